@@ -0,0 +1,145 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+package qatzip
+
+import (
+	"runtime"
+	"sync"
+)
+
+// AsyncCompressor accepts compression requests from any number of goroutines and completes them
+// on a fixed set of poller goroutines, each locked to its own OS thread with its own QATzip session.
+// Submitting goroutines are parked on Go channels rather than blocking an OS thread in QATzip,
+// so the number of threads blocked in the driver is bounded by the number of pollers.
+type AsyncCompressor struct {
+	mu      sync.RWMutex
+	closed  bool
+	p       params
+	jobs    chan *Ticket // ReqCountThreshold requests queued per poller
+	pollers sync.WaitGroup
+}
+
+// Ticket tracks a request submitted to an AsyncCompressor
+type Ticket struct {
+	in   []byte
+	out  []byte
+	err  error
+	done chan struct{}
+}
+
+// NewAsyncCompressor starts pollers poller threads. Options are applied as for AcquireQzBinding,
+// ReqCountThreshold sets the number of requests queued per poller and PollingMode selects
+// whether idle pollers block (Periodical) or spin (Busy) waiting for requests.
+func NewAsyncCompressor(pollers int, options ...Option) (*AsyncCompressor, error) {
+	if pollers <= 0 {
+		return nil, ErrParamPollers
+	}
+
+	p, err := bindingParams(options...)
+	if err != nil {
+		return nil, err
+	}
+
+	depth := p.ReqCountThreshold
+	if depth < 1 {
+		depth = 1
+	}
+
+	a := &AsyncCompressor{
+		p:    p,
+		jobs: make(chan *Ticket, pollers*depth),
+	}
+
+	// sessions are started up front so that setup errors are reported here
+	sessions := make([]*QzBinding, 0, pollers)
+	for i := 0; i < pollers; i++ {
+		q, err := acquireSession(p)
+		if err != nil {
+			for _, q := range sessions {
+				releaseSession(q)
+			}
+			return nil, err
+		}
+		sessions = append(sessions, q)
+	}
+
+	a.pollers.Add(pollers)
+	for _, q := range sessions {
+		go a.poll(q)
+	}
+
+	return a, nil
+}
+
+// Completes requests until the AsyncCompressor is closed
+func (a *AsyncCompressor) poll(q *QzBinding) {
+	runtime.LockOSThread()
+	if !bindThread(q.device) {
+		defer runtime.UnlockOSThread()
+	}
+	defer a.pollers.Done()
+	defer releaseSession(q)
+
+	for {
+		var t *Ticket
+		var ok bool
+
+		if a.p.PollingMode == Busy {
+			select {
+			case t, ok = <-a.jobs:
+			default:
+				runtime.Gosched()
+				continue
+			}
+		} else {
+			t, ok = <-a.jobs
+		}
+		if !ok {
+			return
+		}
+
+		t.out, t.err = compressInto(q, t.out, t.in)
+		close(t.done)
+	}
+}
+
+// SubmitCompress queues in for compression into out, which is used as by CompressBlock.
+// It blocks only while the request queue is full. in and out must not be modified until the ticket completes.
+func (a *AsyncCompressor) SubmitCompress(in []byte, out []byte) (*Ticket, error) {
+	t := &Ticket{in: in, out: out, done: make(chan struct{})}
+
+	a.mu.RLock()
+	defer a.mu.RUnlock()
+	if a.closed {
+		return nil, ErrAsyncClosed
+	}
+	a.jobs <- t
+
+	return t, nil
+}
+
+// Close completes the queued requests and stops the pollers
+func (a *AsyncCompressor) Close() error {
+	a.mu.Lock()
+	if a.closed {
+		a.mu.Unlock()
+		return ErrAsyncClosed
+	}
+	a.closed = true
+	close(a.jobs)
+	a.mu.Unlock()
+
+	a.pollers.Wait()
+	return nil
+}
+
+// Done returns a channel that is closed when the request completes
+func (t *Ticket) Done() <-chan struct{} {
+	return t.done
+}
+
+// Wait blocks until the request completes and returns the compressed data
+func (t *Ticket) Wait() ([]byte, error) {
+	<-t.done
+	return t.out, t.err
+}
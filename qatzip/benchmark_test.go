@@ -0,0 +1,546 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+package qatzip
+
+import (
+	"bytes"
+	"compress/gzip"
+	"fmt"
+	"io"
+	"math/rand"
+	"os"
+	"path/filepath"
+	"sync"
+	"testing"
+	"time"
+
+	"github.com/DataDog/zstd"
+	"github.com/pierrec/lz4/v4"
+)
+
+// Benchmark configuration
+//
+//	QATGO_BENCH_LARGE=1      include 128MB and 1GB inputs
+//	QATGO_BENCH_CORPUS=dir   benchmark every file in dir (e.g. Silesia or Calgary corpus) against software libraries
+const (
+	benchLargeEnv  = "QATGO_BENCH_LARGE"
+	benchCorpusEnv = "QATGO_BENCH_CORPUS"
+)
+
+var benchAlgorithms = []struct {
+	name string
+	alg  Algorithm
+}{{"deflate", DEFLATE}, {"lz4", LZ4}, {"zstd", ZSTD}}
+
+var benchModes = []struct {
+	name string
+	mode InputBufferMode
+}{{"reserve", Reserve}, {"bounce", Bounce}, {"last", Last}, {"nolast", NoLast}, {"deferlast", DeferLast}}
+
+func benchSizes() []int {
+	sizes := []int{512, 4 * 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024}
+	if os.Getenv(benchLargeEnv) != "" {
+		sizes = append(sizes, 128*1024*1024, 1024*1024*1024)
+	}
+	return sizes
+}
+
+func sizeName(n int) string {
+	switch {
+	case n >= 1024*1024*1024:
+		return fmt.Sprintf("%dGB", n/(1024*1024*1024))
+	case n >= 1024*1024:
+		return fmt.Sprintf("%dMB", n/(1024*1024))
+	case n >= 1024:
+		return fmt.Sprintf("%dKB", n/1024)
+	}
+	return fmt.Sprintf("%dB", n)
+}
+
+var benchDataCache struct {
+	sync.Mutex
+	data []byte
+}
+
+// Returns n bytes of text-like data that compresses roughly 3:1
+func benchData(n int) []byte {
+	benchDataCache.Lock()
+	defer benchDataCache.Unlock()
+
+	if len(benchDataCache.data) < n {
+		words := bytes.Fields([]byte(strGettysBurgAddress))
+		r := rand.New(rand.NewSource(1))
+		b := bytes.NewBuffer(make([]byte, 0, n+64))
+		for b.Len() < n {
+			if r.Intn(8) == 0 {
+				fmt.Fprintf(b, "%d ", r.Int63())
+				continue
+			}
+			b.Write(words[r.Intn(len(words))])
+			b.WriteByte(" \n"[r.Intn(2)])
+		}
+		benchDataCache.data = b.Bytes()
+	}
+	return benchDataCache.data[:n]
+}
+
+// Skips the benchmark if the algorithm is not available on this system
+func benchSkip(b *testing.B, err error) {
+	switch err {
+	case nil:
+	case ErrUnsupportedFmt, ErrNoSwUnsupportedFmt, ErrNoSwAvail:
+		b.Skipf("algorithm not supported on this system: %v", err)
+	default:
+		b.Fatalf("error: %v", err)
+	}
+}
+
+// Compressed output buffer large enough for any input of length n
+func benchOutputBuf(n int) []byte {
+	return make([]byte, n+n/2+64*1024)
+}
+
+// Compresses data through a pooled QzBinding with last=true
+func benchCompressBinding(b *testing.B, q *QzBinding, data []byte, out []byte) {
+	q.SetLast(true)
+	for c := 0; c < len(data); {
+		in, _, err := q.Compress(data[c:], out)
+		if err != nil {
+			b.Fatalf("error: compress failed: %v", err)
+		}
+		c += in
+	}
+}
+
+func BenchmarkCompressBinding(b *testing.B) {
+	for _, a := range benchAlgorithms {
+		for _, n := range benchSizes() {
+			b.Run(a.name+"/"+sizeName(n), func(b *testing.B) {
+				q, err := AcquireQzBinding(AlgorithmOption(a.alg))
+				benchSkip(b, err)
+				defer q.Release()
+
+				data := benchData(n)
+				out := benchOutputBuf(n)
+
+				b.SetBytes(int64(n))
+				b.ResetTimer()
+				for i := 0; i < b.N; i++ {
+					benchCompressBinding(b, q, data, out)
+				}
+			})
+		}
+	}
+}
+
+// Cost of latency sampling on small requests (SetMetricsSampling)
+func BenchmarkCompressMetrics(b *testing.B) {
+	const n = 4096
+	for _, rate := range []int{0, 1, 64} {
+		b.Run(fmt.Sprintf("sampling-%d", rate), func(b *testing.B) {
+			q, err := AcquireQzBinding()
+			benchSkip(b, err)
+			defer q.Release()
+			SetMetricsSampling(rate)
+			defer SetMetricsSampling(0)
+
+			data := benchData(n)
+			out := benchOutputBuf(n)
+
+			b.SetBytes(n)
+			b.ResetTimer()
+			for i := 0; i < b.N; i++ {
+				benchCompressBinding(b, q, data, out)
+			}
+		})
+	}
+}
+
+// Concurrent requests routed between QAT and software by HybridCompressor
+func BenchmarkCompressHybrid(b *testing.B) {
+	for _, a := range benchAlgorithms {
+		for _, n := range []int{4096, 64 * 1024} {
+			b.Run(a.name+"/"+sizeName(n), func(b *testing.B) {
+				h, err := NewHybridCompressor(4, AlgorithmOption(a.alg))
+				benchSkip(b, err)
+				data := benchData(n)
+
+				b.SetBytes(int64(n))
+				b.ResetTimer()
+				b.RunParallel(func(pb *testing.PB) {
+					out := benchOutputBuf(n)
+					for pb.Next() {
+						if _, err := h.Compress(out, data); err != nil {
+							b.Fatal(err)
+						}
+					}
+				})
+				s := h.Stats()
+				b.ReportMetric(float64(s.SwRequests)/float64(s.HwRequests+s.SwRequests), "sw-ratio")
+			})
+		}
+	}
+}
+
+func BenchmarkCompressWriter(b *testing.B) {
+	for _, a := range benchAlgorithms {
+		for _, n := range benchSizes() {
+			b.Run(a.name+"/"+sizeName(n), func(b *testing.B) {
+				data := benchData(n)
+				z := NewWriter(io.Discard)
+				z.Apply(AlgorithmOption(a.alg))
+
+				b.SetBytes(int64(n))
+				b.ResetTimer()
+				for i := 0; i < b.N; i++ {
+					benchSkip(b, z.Reset(io.Discard))
+					if _, err := z.Write(data); err != nil {
+						b.Fatalf("error: write failed: %v", err)
+					}
+					if err := z.Close(); err != nil {
+						b.Fatalf("error: close failed: %v", err)
+					}
+				}
+			})
+		}
+	}
+}
+
+func BenchmarkCompressBlock(b *testing.B) {
+	for _, a := range benchAlgorithms {
+		for _, n := range []int{512, 4 * 1024, 64 * 1024} {
+			b.Run(a.name+"/"+sizeName(n), func(b *testing.B) {
+				data := benchData(n)
+				dst := make([]byte, CompressBound(a.alg, n))
+				_, err := CompressBlock(dst, data, AlgorithmOption(a.alg))
+				benchSkip(b, err)
+
+				b.SetBytes(int64(n))
+				b.ResetTimer()
+				for i := 0; i < b.N; i++ {
+					if _, err := CompressBlock(dst, data, AlgorithmOption(a.alg)); err != nil {
+						b.Fatalf("error: compress failed: %v", err)
+					}
+				}
+			})
+		}
+	}
+}
+
+// CompressBlock from and into pinned memory compared with Go heap buffers (BenchmarkCompressBlock)
+func BenchmarkCompressBlockPinned(b *testing.B) {
+	for _, a := range benchAlgorithms {
+		for _, n := range []int{64 * 1024, 1024 * 1024} {
+			b.Run(a.name+"/"+sizeName(n), func(b *testing.B) {
+				src, err := AllocBuffer(n)
+				if err != nil {
+					b.Skip("no pinned memory")
+				}
+				defer FreeBuffer(src)
+				dst, err := AllocBuffer(CompressBound(a.alg, n))
+				if err != nil {
+					b.Skip("no pinned memory")
+				}
+				defer FreeBuffer(dst)
+				copy(src, benchData(n))
+				_, err = CompressBlock(dst, src, AlgorithmOption(a.alg))
+				benchSkip(b, err)
+
+				b.SetBytes(int64(n))
+				b.ResetTimer()
+				for i := 0; i < b.N; i++ {
+					if _, err := CompressBlock(dst, src, AlgorithmOption(a.alg)); err != nil {
+						b.Fatalf("error: compress failed: %v", err)
+					}
+				}
+			})
+		}
+	}
+}
+
+// 64 messages per batch compared with one CompressBlock call per message (BenchmarkCompressBlock)
+func BenchmarkCompressBatch(b *testing.B) {
+	const count = 64
+
+	for _, a := range benchAlgorithms {
+		for _, n := range []int{512, 4 * 1024} {
+			b.Run(a.name+"/"+sizeName(n), func(b *testing.B) {
+				data := benchData(n * count)
+				ins := make([][]byte, count)
+				outs := make([][]byte, count)
+				for i := range ins {
+					ins[i] = data[i*n : (i+1)*n]
+					outs[i] = make([]byte, CompressBound(a.alg, n))
+				}
+				q, err := AcquireQzBinding(AlgorithmOption(a.alg))
+				benchSkip(b, err)
+				defer q.Release()
+
+				b.SetBytes(int64(n * count))
+				b.ResetTimer()
+				for i := 0; i < b.N; i++ {
+					if _, err := q.CompressBatch(ins, outs); err != nil {
+						b.Fatalf("error: compress failed: %v", err)
+					}
+				}
+			})
+		}
+	}
+}
+
+// Streams 16MB through the Writer in 64KB writes in each input buffer mode
+func BenchmarkCompressInputBufferMode(b *testing.B) {
+	const n, chunk = 16 * 1024 * 1024, 64 * 1024
+
+	for _, a := range benchAlgorithms {
+		for _, m := range benchModes {
+			b.Run(a.name+"/"+m.name, func(b *testing.B) {
+				data := benchData(n)
+				z := NewWriter(io.Discard)
+				z.Apply(AlgorithmOption(a.alg), InputBufferModeOption(m.mode))
+
+				b.SetBytes(n)
+				b.ResetTimer()
+				for i := 0; i < b.N; i++ {
+					benchSkip(b, z.Reset(io.Discard))
+					for c := 0; c < n; c += chunk {
+						if _, err := z.Write(data[c : c+chunk]); err != nil {
+							b.Fatalf("error: write failed: %v", err)
+						}
+					}
+					if err := z.Close(); err != nil {
+						b.Fatalf("error: close failed: %v", err)
+					}
+				}
+			})
+		}
+	}
+}
+
+// One pooled session per goroutine
+func BenchmarkCompressParallel(b *testing.B) {
+	for _, a := range benchAlgorithms {
+		for _, n := range []int{64 * 1024, 1024 * 1024} {
+			b.Run(a.name+"/"+sizeName(n), func(b *testing.B) {
+				data := benchData(n)
+				q, err := AcquireQzBinding(AlgorithmOption(a.alg))
+				benchSkip(b, err)
+				q.Release()
+
+				b.SetBytes(int64(n))
+				b.ResetTimer()
+				b.RunParallel(func(pb *testing.PB) {
+					q, err := AcquireQzBinding(AlgorithmOption(a.alg))
+					if err != nil {
+						b.Errorf("error: could not acquire session: %v", err)
+						return
+					}
+					defer q.Release()
+
+					out := benchOutputBuf(n)
+					for pb.Next() {
+						benchCompressBinding(b, q, data, out)
+					}
+				})
+			})
+		}
+	}
+}
+
+// ZSTD software parameters against the QAT sequence producer (level <= 12, no workers or long distance matching)
+func BenchmarkCompressZstdParams(b *testing.B) {
+	const n = 16 * 1024 * 1024
+
+	for _, c := range []struct {
+		name    string
+		options []Option
+	}{
+		{"qat_level3", []Option{CompressionLevelOption(3)}},
+		{"sw_level19", []Option{CompressionLevelOption(19)}},
+		{"sw_level3_workers4", []Option{CompressionLevelOption(3), ZstdWorkersOption(4)}},
+		{"sw_level19_workers4", []Option{CompressionLevelOption(19), ZstdWorkersOption(4)}},
+		{"sw_level3_ldm", []Option{CompressionLevelOption(3), ZstdLongDistanceOption(true), ZstdWindowLogOption(27)}},
+		{"qat_level3_checksum", []Option{CompressionLevelOption(3), ZstdChecksumOption(true)}},
+	} {
+		b.Run(c.name, func(b *testing.B) {
+			data := benchData(n)
+			z := NewWriter(io.Discard)
+			z.Apply(append([]Option{AlgorithmOption(ZSTD)}, c.options...)...)
+
+			var ratio float64
+			b.SetBytes(n)
+			b.ResetTimer()
+			for i := 0; i < b.N; i++ {
+				benchSkip(b, z.Reset(io.Discard))
+				if _, err := z.Write(data); err != nil {
+					b.Fatalf("error: write failed: %v", err)
+				}
+				if err := z.Close(); err != nil {
+					b.Fatalf("error: close failed: %v", err)
+				}
+				perf := z.GetPerf()
+				ratio = float64(perf.BytesIn) / float64(perf.BytesOut)
+			}
+			b.ReportMetric(ratio, "ratio")
+		})
+	}
+}
+
+// Compresses data with the Writer, used as input for decompression benchmarks
+func benchCompressed(b *testing.B, alg Algorithm, data []byte) []byte {
+	buf := new(bytes.Buffer)
+	z := NewWriter(buf)
+	z.Apply(AlgorithmOption(alg))
+	_, err := z.Write(data)
+	if err == nil {
+		err = z.Close()
+	}
+	benchSkip(b, err)
+	return buf.Bytes()
+}
+
+func BenchmarkDecompressReader(b *testing.B) {
+	for _, a := range benchAlgorithms {
+		for _, n := range benchSizes() {
+			b.Run(a.name+"/"+sizeName(n), func(b *testing.B) {
+				compressed := benchCompressed(b, a.alg, benchData(n))
+				z, _ := NewReader(nil)
+				z.Apply(AlgorithmOption(a.alg))
+
+				b.SetBytes(int64(n))
+				b.ResetTimer()
+				for i := 0; i < b.N; i++ {
+					benchSkip(b, z.Reset(bytes.NewReader(compressed)))
+					// hide WriterTo so that Reader.Read is measured
+					if _, err := io.Copy(io.Discard, struct{ io.Reader }{z}); err != nil {
+						b.Fatalf("error: read failed: %v", err)
+					}
+				}
+				z.Close()
+			})
+		}
+	}
+}
+
+// Input stream with a fixed latency per read of at most 64KB, as from a network stream
+type latencyReader struct {
+	r       io.Reader
+	latency time.Duration
+}
+
+func (l latencyReader) Read(p []byte) (int, error) {
+	time.Sleep(l.latency)
+	return l.r.Read(p[:minInt(len(p), 64*1024)])
+}
+
+// Reader on a high latency input stream without and with read-ahead
+func BenchmarkDecompressReadAhead(b *testing.B) {
+	const n = 4 * 1024 * 1024
+	for _, a := range benchAlgorithms {
+		compressed := benchCompressed(b, a.alg, benchData(n))
+		for _, depth := range []int{0, 4} {
+			b.Run(fmt.Sprintf("%s/depth%d", a.name, depth), func(b *testing.B) {
+				z, _ := NewReader(nil)
+				z.Apply(AlgorithmOption(a.alg), ReadAheadOption(depth, 64*1024))
+
+				b.SetBytes(n)
+				b.ResetTimer()
+				for i := 0; i < b.N; i++ {
+					benchSkip(b, z.Reset(latencyReader{r: bytes.NewReader(compressed), latency: 100 * time.Microsecond}))
+					if _, err := io.Copy(io.Discard, struct{ io.Reader }{z}); err != nil {
+						b.Fatalf("error: read failed: %v", err)
+					}
+				}
+				z.Close()
+			})
+		}
+	}
+}
+
+// Software baselines for the sizes used above
+func BenchmarkCompressSoftware(b *testing.B) {
+	for _, n := range benchSizes() {
+		data := benchData(n)
+		b.Run("gzip/"+sizeName(n), func(b *testing.B) {
+			benchSoftware(b, data, func(w io.Writer) io.WriteCloser {
+				g, _ := gzip.NewWriterLevel(w, DefaultCompression)
+				return g
+			})
+		})
+		b.Run("lz4/"+sizeName(n), func(b *testing.B) {
+			benchSoftware(b, data, func(w io.Writer) io.WriteCloser { return lz4.NewWriter(w) })
+		})
+		b.Run("zstd/"+sizeName(n), func(b *testing.B) {
+			benchSoftware(b, data, func(w io.Writer) io.WriteCloser { return zstd.NewWriterLevel(w, DefaultCompression) })
+		})
+	}
+}
+
+func benchSoftware(b *testing.B, data []byte, newWriter func(io.Writer) io.WriteCloser) {
+	b.SetBytes(int64(len(data)))
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		w := newWriter(io.Discard)
+		if _, err := w.Write(data); err != nil {
+			b.Fatalf("error: write failed: %v", err)
+		}
+		if err := w.Close(); err != nil {
+			b.Fatalf("error: close failed: %v", err)
+		}
+	}
+}
+
+// Compresses every file in the corpus with QAT and the software libraries
+func BenchmarkCorpus(b *testing.B) {
+	dir := os.Getenv(benchCorpusEnv)
+	if dir == "" {
+		b.Skipf("set %s to a corpus directory", benchCorpusEnv)
+	}
+
+	files, err := filepath.Glob(filepath.Join(dir, "*"))
+	if err != nil {
+		b.Fatal(err)
+	}
+
+	for _, f := range files {
+		data, err := os.ReadFile(f)
+		if err != nil || len(data) == 0 {
+			continue
+		}
+		name := filepath.Base(f)
+
+		for _, a := range benchAlgorithms {
+			b.Run(name+"/qat_"+a.name, func(b *testing.B) {
+				var ratio float64
+				z := NewWriter(io.Discard)
+				z.Apply(AlgorithmOption(a.alg))
+
+				b.SetBytes(int64(len(data)))
+				b.ResetTimer()
+				for i := 0; i < b.N; i++ {
+					benchSkip(b, z.Reset(io.Discard))
+					z.Write(data)
+					if err := z.Close(); err != nil {
+						b.Fatalf("error: close failed: %v", err)
+					}
+					perf := z.GetPerf()
+					ratio = float64(perf.BytesIn) / float64(perf.BytesOut)
+				}
+				b.ReportMetric(ratio, "ratio")
+			})
+		}
+
+		b.Run(name+"/sw_gzip", func(b *testing.B) {
+			benchSoftware(b, data, func(w io.Writer) io.WriteCloser {
+				g, _ := gzip.NewWriterLevel(w, DefaultCompression)
+				return g
+			})
+		})
+		b.Run(name+"/sw_lz4", func(b *testing.B) {
+			benchSoftware(b, data, func(w io.Writer) io.WriteCloser { return lz4.NewWriter(w) })
+		})
+		b.Run(name+"/sw_zstd", func(b *testing.B) {
+			benchSoftware(b, data, func(w io.Writer) io.WriteCloser { return zstd.NewWriterLevel(w, DefaultCompression) })
+		})
+	}
+}
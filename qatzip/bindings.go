@@ -5,10 +5,12 @@ package qatzip
 /*
 #include "qatzip_internal.h"
 #cgo pkg-config: qatzip
-#cgo LDFLAGS: -ldl
+#cgo LDFLAGS: -ldl -lpthread
 */
 import "C"
 
+import "hash/crc32"
+
 const (
 	DEFLATE_ID uint8 = C.QZ_DEFLATE
 	LZ4_ID     uint8 = C.QZ_LZ4
@@ -19,6 +21,8 @@ type QzBinding struct {
 	state  *C.qatzip_state_t
 	p      params
 	closed bool
+	perf   *Perf // stream the session reports request counters to
+	device int   // device the session is counted in flight on, DeviceAuto if not placed
 }
 
 func (q *QzBinding) getDebug() DebugLevel {
@@ -28,6 +32,7 @@ func (q *QzBinding) getDebug() DebugLevel {
 // Create QATzip session state
 func NewQzBinding() (q *QzBinding, err error) {
 	q = new(QzBinding)
+	q.device = DeviceAuto
 	q.state = C.qatzip_init()
 
 	if q.state == nil {
@@ -63,11 +68,23 @@ func (q *QzBinding) StartSession() (err error) {
 		q.state.algorithm = C.int(LZ4)
 	case ZSTD:
 		q.state.zstd_session.level = C.int(q.p.Level)
+		q.state.zstd_session.nb_workers = C.int(q.p.ZstdWorkers)
+		q.state.zstd_session.job_size = C.int(q.p.ZstdJobSize)
+		q.state.zstd_session.long_distance = C.int(q.p.ZstdLongDistance)
+		q.state.zstd_session.window_log = C.int(q.p.ZstdWindowLog)
+		q.state.zstd_session.checksum = C.int(q.p.ZstdChecksum)
 		q.state.algorithm = C.int(ZSTD)
+		if err = q.setZstdDictionary(); err != nil {
+			return err
+		}
 	default:
 		return ErrParams
 	}
 
+	if q.p.ZstdDictionary != nil && q.p.Algorithm != ZSTD {
+		return ErrParamZstdDictionary
+	}
+
 	// initialize common QAT parameters
 	if commonParams != nil {
 		if q.p.Direction != 0 {
@@ -77,7 +94,7 @@ func (q *QzBinding) StartSession() (err error) {
 			commonParams.comp_lvl = C.uint(q.p.Level)
 		}
 		if q.p.SwBackup != 0 {
-			commonParams.sw_backup = C.uchar(q.p.SwBackup)
+			commonParams.sw_backup = C.uchar(booltoInt(q.p.SwBackup > 0))
 		}
 		if q.p.MaxForks != 0 {
 			commonParams.max_forks = C.uint(q.p.MaxForks)
@@ -119,6 +136,30 @@ func (q *QzBinding) StartSession() (err error) {
 	return nil
 }
 
+// References the prepared dictionaries needed for the session direction
+func (q *QzBinding) setZstdDictionary() error {
+	d := q.p.ZstdDictionary
+	if d == nil {
+		return nil
+	}
+
+	if q.p.Direction != Decompress {
+		c, err := d.cdict(q.p.Level)
+		if err != nil {
+			return err
+		}
+		q.state.zstd_session.cdict = c
+	}
+	if q.p.Direction != Compress {
+		dd, err := d.prepareDDict()
+		if err != nil {
+			return err
+		}
+		q.state.zstd_session.ddict = dd
+	}
+	return nil
+}
+
 // End QATzip session
 func (q *QzBinding) Close() (err error) {
 	if q.closed {
@@ -126,6 +167,9 @@ func (q *QzBinding) Close() (err error) {
 	}
 
 	q.closed = true
+	q.collectStats()
+	q.perf = nil
+	q.unplace()
 	status := int(C.qatzip_close(q.state))
 	if status != 0 {
 		return Error(status)
@@ -140,9 +184,11 @@ func (q *QzBinding) Compress(in []byte, out []byte) (c int, p int, err error) {
 		return
 	}
 
+	t := metricsStart()
 	status := int(C.qatzip_compress(q.state,
 		(*C.uchar)(&in[0]), C.uint(len(in)),
 		(*C.uchar)(&out[0]), C.uint(len(out))))
+	metricsEnd(&metrics.compress, t)
 
 	c = int(q.state.stream.in_sz)
 	p = int(q.state.stream.out_sz)
@@ -158,9 +204,11 @@ func (q *QzBinding) CompressCRC(in []byte, out []byte, crc *uint64) (c int, p in
 		return
 	}
 
+	t := metricsStart()
 	status := int(C.qatzip_compress_crc(q.state,
 		(*C.uchar)(&in[0]), C.uint(len(in)),
 		(*C.uchar)(&out[0]), C.uint(len(out)), (*C.ulong)(crc)))
+	metricsEnd(&metrics.compress, t)
 
 	c = int(q.state.stream.in_sz)
 	p = int(q.state.stream.out_sz)
@@ -169,6 +217,121 @@ func (q *QzBinding) CompressCRC(in []byte, out []byte, crc *uint64) (c int, p in
 	return
 }
 
+// Result of one input of CompressBatch
+type BatchResult struct {
+	Out []byte // compressed member/frame
+	CRC uint32 // CRC-32 of the input
+	Err error
+}
+
+// CompressBatch compresses each input into a complete member/frame with a single cgo call.
+// outs is optional, outs[i] receives the result of ins[i] if its capacity is large enough.
+// Inputs and outputs are staged through pooled buffers because
+// cgo does not allow passing Go memory that holds Go pointers to C.
+func (q *QzBinding) CompressBatch(ins [][]byte, outs [][]byte) (results []BatchResult, err error) {
+	if len(outs) > 0 && len(outs) != len(ins) {
+		return nil, ErrParams
+	}
+
+	results = make([]BatchResult, len(ins))
+	inSizes := make([]C.uint, 0, len(ins))
+	outSizes := make([]C.uint, 0, len(ins))
+	index := make([]int, 0, len(ins)) // result for each batch entry
+	inLen, outLen := 0, 0
+	for i, in := range ins {
+		if len(in) == 0 {
+			results[i].Out, results[i].Err = emptyStream(q.p)
+			continue
+		}
+		bound := CompressBound(q.p.Algorithm, len(in))
+		inSizes = append(inSizes, C.uint(len(in)))
+		outSizes = append(outSizes, C.uint(bound))
+		index = append(index, i)
+		inLen += len(in)
+		outLen += bound
+	}
+	if len(index) == 0 {
+		return results, nil
+	}
+
+	inBuf := getBuffer(inLen)
+	outBuf := getBuffer(outLen)
+	defer putBuffer(inBuf)
+	defer putBuffer(outBuf)
+
+	off := 0
+	for _, i := range index {
+		off += copy(inBuf[off:], ins[i])
+	}
+
+	crcs := make([]C.ulong, len(index))
+	statuses := make([]C.int, len(index))
+	C.qatzip_compress_batch(q.state,
+		(*C.uchar)(&inBuf[0]), &inSizes[0],
+		(*C.uchar)(&outBuf[0]), &outSizes[0], &crcs[0], &statuses[0], C.uint(len(index)))
+
+	off = 0
+	for j, i := range index {
+		n := int(outSizes[j])
+		r := &results[i]
+		if r.Err = Error(int(statuses[j])); r.Err == nil {
+			if len(outs) > 0 && cap(outs[i]) >= n {
+				r.Out = outs[i][:n]
+			} else {
+				r.Out = make([]byte, n)
+			}
+			copy(r.Out, outBuf[off:off+n])
+
+			if q.p.Algorithm == DEFLATE {
+				r.CRC = uint32(crcs[j])
+			} else {
+				r.CRC = crc32.ChecksumIEEE(ins[i])
+			}
+		}
+		off += CompressBound(q.p.Algorithm, len(ins[i]))
+	}
+
+	return results, nil
+}
+
+// Ends the stream of a ZSTD session compressed with last=false, flushing buffered data into out.
+// Pending() reports whether more output remains to be flushed.
+func (q *QzBinding) finish(out []byte) (p int, err error) {
+	if len(out) == 0 {
+		err = ErrEmptyBuffer
+		return
+	}
+
+	q.SetLast(true)
+	status := int(C.qatzip_compress_crc(q.state, nil, 0,
+		(*C.uchar)(&out[0]), C.uint(len(out)), nil))
+
+	p = int(q.state.stream.out_sz)
+	err = Error(status)
+
+	return
+}
+
+// Flushes the data buffered by a ZSTD session into out without ending the frame.
+// Pending() reports whether more output remains to be flushed.
+func (q *QzBinding) flush(out []byte) (p int, err error) {
+	if len(out) == 0 {
+		err = ErrEmptyBuffer
+		return
+	}
+
+	q.SetLast(false)
+	q.state.flush = C.int(1)
+	status := int(C.qatzip_compress_crc(q.state, nil, 0,
+		(*C.uchar)(&out[0]), C.uint(len(out)), nil))
+	q.state.flush = C.int(0)
+
+	p = int(q.state.stream.out_sz)
+	err = Error(status)
+
+	return
+}
+
 // Set last flag for QATzip compress
 func (q *QzBinding) SetLast(enable bool) {
 	if enable {
@@ -178,15 +341,22 @@ func (q *QzBinding) SetLast(enable bool) {
 	}
 }
 
+// Reports whether the last flag is set
+func (q *QzBinding) isLast() bool {
+	return q.state.last != 0
+}
+
 // QATzip decompress (in = input buffer, out = output buffer, c = consumed, p = produced)
 func (q *QzBinding) Decompress(in []byte, out []byte) (c int, p int, err error) {
 	if len(in) == 0 {
 		err = ErrEmptyBuffer
 		return
 	}
+	t := metricsStart()
 	status := int(C.qatzip_decompress(q.state,
 		(*C.uchar)(&in[0]), C.uint(len(in)),
 		(*C.uchar)(&out[0]), C.uint(len(out))))
+	metricsEnd(&metrics.decompress, t)
 
 	c = int(q.state.stream.in_sz)
 	p = int(q.state.stream.out_sz)
@@ -195,6 +365,64 @@ func (q *QzBinding) Decompress(in []byte, out []byte) (c int, p int, err error)
 	return
 }
 
+// QATzip streaming decompress (in = input buffer, out = output buffer, c = consumed, p = produced)
+// Input may be fed in arbitrarily sized pieces and may be empty to drain pending output.
+// SetLast(true) marks the end of the compressed input stream.
+func (q *QzBinding) DecompressStream(in []byte, out []byte) (c int, p int, err error) {
+	var inPtr *C.uchar
+
+	if len(out) == 0 {
+		err = ErrEmptyBuffer
+		return
+	}
+	if len(in) > 0 {
+		inPtr = (*C.uchar)(&in[0])
+	}
+
+	t := metricsStart()
+	status := int(C.qatzip_decompress_stream(q.state,
+		inPtr, C.uint(len(in)),
+		(*C.uchar)(&out[0]), C.uint(len(out))))
+	metricsEnd(&metrics.decompress, t)
+
+	c = int(q.state.stream.in_sz)
+	p = int(q.state.stream.out_sz)
+	err = Error(status)
+
+	return
+}
+
+// ZSTD single-shot decompress of complete frames whose content fits in out (c = consumed, p = produced)
+// Only valid between frames of a stream, see inFrame.
+func (q *QzBinding) decompressFrames(in []byte, out []byte) (c int, p int, err error) {
+	if len(in) == 0 || len(out) == 0 {
+		err = ErrEmptyBuffer
+		return
+	}
+
+	t := metricsStart()
+	status := int(C.qatzip_zstd_decompress_frames(q.state,
+		(*C.uchar)(&in[0]), C.uint(len(in)),
+		(*C.uchar)(&out[0]), C.uint(len(out))))
+	metricsEnd(&metrics.decompress, t)
+
+	c = int(q.state.stream.in_sz)
+	p = int(q.state.stream.out_sz)
+	err = Error(status)
+
+	return
+}
+
+// Reports whether the ZSTD stream decoder has started a frame it has not completed
+func (q *QzBinding) inFrame() bool {
+	return q.state.zstd_session.in_frame != 0
+}
+
+// Reports whether QATzip is holding buffered stream data that has not been returned yet
+func (q *QzBinding) Pending() bool {
+	return q.state.stream.pending_in > 0 || q.state.stream.pending_out > 0
+}
+
 // Apply options to QATzip session state
 func (q *QzBinding) Apply(options ...Option) (err error) {
 	for _, op := range options {
@@ -204,3 +432,16 @@ func (q *QzBinding) Apply(options ...Option) (err error) {
 	}
 	return
 }
+
+// Discard stream state while keeping the QATzip session open for reuse
+func (q *QzBinding) resetStream() (err error) {
+	if q.closed {
+		return ErrNone
+	}
+
+	status := int(C.qatzip_reset_stream(q.state))
+	if status != 0 {
+		return Error(status)
+	}
+	return nil
+}
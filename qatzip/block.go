@@ -0,0 +1,107 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+package qatzip
+
+import "math"
+
+// CompressBlock compresses src as a complete gzip, LZ4 or ZSTD stream into the start of dst and
+// returns the compressed bytes. dst is used if its capacity is at least
+// CompressBound(alg, len(src)), otherwise a new buffer is allocated. The session is taken from
+// the process-wide session pool, options are applied as for AcquireQzBinding.
+func CompressBlock(dst []byte, src []byte, options ...Option) ([]byte, error) {
+	q, err := AcquireQzBinding(options...)
+	if err != nil {
+		return nil, err
+	}
+	defer q.Release()
+
+	return compressInto(q, dst, src)
+}
+
+// Compresses src with last=1 into dst, see CompressBlock
+func compressInto(q *QzBinding, dst []byte, src []byte) ([]byte, error) {
+	if len(src) == 0 {
+		buf, err := emptyStream(q.p)
+		if err != nil {
+			return nil, err
+		}
+		return append(dst[:0], buf...), nil
+	}
+
+	if bound := CompressBound(q.p.Algorithm, len(src)); cap(dst) < bound {
+		dst = make([]byte, bound)
+	}
+	dst = dst[:cap(dst)]
+
+	n := 0
+	q.SetLast(true)
+	for consumed := 0; consumed < len(src); {
+		c, p, err := q.Compress(src[consumed:], dst[n:])
+		if err == nil && c == 0 {
+			err = ErrBuffer
+		}
+		if err != nil {
+			return nil, err
+		}
+		consumed += c
+		n += p
+	}
+	if q.Pending() {
+		return nil, ErrBuffer
+	}
+
+	return dst[:n], nil
+}
+
+// DecompressBlock decompresses the complete members/frames in src into dst and returns the result.
+// dst is used if its capacity holds the decompressed size, otherwise a new buffer is allocated.
+// The decompressed size is taken from QATzip gzip, LZ4 and ZSTD headers when they record it,
+// otherwise the output grows up to MaxBufferLength. Returns ErrBuffer if the output does not fit in MaxBufferLength.
+func DecompressBlock(dst []byte, src []byte, options ...Option) ([]byte, error) {
+	if len(src) == 0 {
+		return nil, ErrEmptyBuffer
+	}
+
+	q, err := AcquireQzBinding(options...)
+	if err != nil {
+		return nil, err
+	}
+	defer q.Release()
+
+	size := blockSize(q.p.Algorithm, src)
+	out := dst[:cap(dst)]
+	if size < 0 && len(out) == 0 {
+		out = make([]byte, 4*len(src)+MinBufferLength)
+	}
+
+	out, n, err := decompressBlock(q, src, out, size, q.p.MaxBufferLength)
+	if err != nil {
+		return nil, err
+	}
+	return out[:n], nil
+}
+
+// Returns the total uncompressed size recorded in the member/frame headers of src, -1 if unknown
+func blockSize(alg Algorithm, src []byte) int {
+	s := memberScanner{
+		alg: alg,
+		ensure: func(n int) error {
+			if n > len(src) {
+				return ErrData
+			}
+			return nil
+		},
+		buf: func() []byte { return src },
+	}
+
+	total := 0
+	for start := 0; start < len(src); {
+		size, usize, err := s.next(start)
+		if err != nil || usize < 0 || usize > math.MaxInt-total {
+			return -1
+		}
+		total += usize
+		start += size
+	}
+	return total
+}
@@ -0,0 +1,103 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+package qatzip
+
+import (
+	"math/bits"
+	"sync"
+)
+
+const (
+	// buffers are pooled in power of two size classes from MinBufferLength to DefaultMaxBufferLength
+	minBufferTierShift = 17 // MinBufferLength
+	bufferTiers        = 11
+
+	qzChunkOverhead = 64 // header, footer and block headers per hardware buffer (DEFLATE, LZ4)
+	qzSkidPad       = 1024
+)
+
+// Process-wide pool of I/O buffers shared by Writers, Readers and ParallelWriters, pinned buffers are
+// used first when SetPinnedBufferLimit allows them
+var bufferPools [bufferTiers]sync.Pool
+
+// Returns the size class for a buffer of n bytes, -1 if buffers of this size are not pooled
+func bufferTier(n int) int {
+	if n <= MinBufferLength {
+		return 0
+	}
+	t := bits.Len(uint(n-1)) - minBufferTierShift
+	if t >= bufferTiers {
+		return -1
+	}
+	return t
+}
+
+// Returns a buffer of length n from the buffer pool
+func getBuffer(n int) []byte {
+	t := bufferTier(n)
+	if t < 0 {
+		return make([]byte, n)
+	}
+	if b := getPinned(t); b != nil {
+		return b[:n]
+	}
+	if b, ok := bufferPools[t].Get().(*[]byte); ok {
+		return (*b)[:n]
+	}
+	return make([]byte, n, MinBufferLength<<t)
+}
+
+// Returns a buffer obtained from getBuffer to the buffer pool
+func putBuffer(b []byte) {
+	if putPinned(b) {
+		return
+	}
+	t := bufferTier(cap(b))
+	if t < 0 || cap(b) != MinBufferLength<<t {
+		return
+	}
+	b = b[:cap(b)]
+	bufferPools[t].Put(&b)
+}
+
+// CompressBound returns the largest compressed size of n bytes of input for algorithm alg.
+// A dst with at least this capacity is never reallocated by CompressBlock.
+func CompressBound(alg Algorithm, n int) int {
+	if alg == ZSTD {
+		// ZSTD_COMPRESSBOUND
+		bound := n + n>>8
+		if n < 128*1024 {
+			bound += (128*1024 - n) >> 11
+		}
+		return bound
+	}
+
+	// stored blocks plus a member/frame header and footer per hardware buffer
+	chunks := n/defaultHwBufSize + 1
+	return n + n>>3 + chunks*qzChunkOverhead + qzSkidPad
+}
+
+// Largest input whose compressed size is guaranteed to fit in n bytes
+func maxInputLength(alg Algorithm, n int) int {
+	if alg == ZSTD {
+		m := n - n>>7 - 4096
+		if m < 0 {
+			return 0
+		}
+		return m
+	}
+
+	m := (n - qzSkidPad) * 8 / 9
+	m -= (m/defaultHwBufSize + 1) * qzChunkOverhead
+	if m < 0 {
+		return 0
+	}
+	return m
+}
+
+func minInt(a, b int) int {
+	if a < b {
+		return a
+	}
+	return b
+}
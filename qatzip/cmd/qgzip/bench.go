@@ -0,0 +1,353 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+package main
+
+import (
+	"bytes"
+	"compress/flate"
+	"compress/gzip"
+	"flag"
+	"fmt"
+	"io"
+	"os"
+	"strconv"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"syscall"
+	"time"
+
+	"github.com/DataDog/zstd"
+	"github.com/intel/qatgo/qatzip"
+	"github.com/pierrec/lz4/v4"
+)
+
+var (
+	bench        = flag.Bool("bench", false, "benchmark in-memory block compression of the input files, CSV on stdout")
+	benchThreads = flag.String("bench_threads", "1", "comma separated numbers of goroutines for -bench")
+	benchChunks  = flag.String("bench_chunks", "65536", "comma separated chunk sizes for -bench")
+	benchAlgs    = flag.String("bench_algs", "", "comma separated algorithms for -bench (default -A)")
+)
+
+// Compresses or decompresses one chunk, the result may use the capacity of dst
+type benchFunc func(dst []byte, src []byte) ([]byte, error)
+
+type benchCodec struct {
+	compress   benchFunc
+	decompress benchFunc
+}
+
+// Result of one benchmark case
+type benchResult struct {
+	calls  uint64
+	in     uint64 // bytes passed to the codec
+	out    uint64 // bytes returned by the codec
+	wallNS int64
+	cpuNS  int64 // user and system CPU time of the process
+	exec   qatzip.ExecStats
+	lat    qatzip.LatencySnapshot
+}
+
+// Loads the input files (stdin without files) into memory, splits them into chunks and runs every combination
+// of algorithm, chunk size and number of goroutines for -loop passes over the chunks per goroutine
+func runBench(fileList []string) error {
+	var corpus []byte
+	if len(fileList) == 0 {
+		fileList = []string{"-"}
+	}
+	for _, name := range fileList {
+		var b []byte
+		var err error
+		if name == "-" {
+			b, err = io.ReadAll(os.Stdin)
+		} else {
+			b, err = os.ReadFile(name)
+		}
+		if err != nil {
+			return err
+		}
+		corpus = append(corpus, b...)
+	}
+	if len(corpus) == 0 {
+		return fmt.Errorf("error: empty benchmark input")
+	}
+
+	threadList, err := parseBenchList(*benchThreads)
+	if err != nil {
+		return err
+	}
+	chunkList, err := parseBenchList(*benchChunks)
+	if err != nil {
+		return err
+	}
+	algs := *benchAlgs
+	if algs == "" {
+		algs = *algorithm
+	}
+
+	// sessions for every goroutine are created before the first measurement
+	maxThreads := 0
+	for _, t := range threadList {
+		if t > maxThreads {
+			maxThreads = t
+		}
+	}
+	if err := qatzip.SetSessionPoolSize(maxThreads, maxThreads); err != nil {
+		return err
+	}
+
+	op := "c"
+	if *decompress {
+		op = "d"
+	}
+
+	fmt.Println("op,alg,chunk,threads,calls,bytes,ratio,time_ms,mbps,cpu_s_per_gb,p50_us,p99_us,p999_us,hw_requests,sw_requests")
+	for _, alg := range strings.Split(algs, ",") {
+		codec, err := newBenchCodec(alg, *level)
+		if err != nil {
+			return err
+		}
+
+		for _, chunk := range chunkList {
+			var chunks [][]byte
+			for off := 0; off < len(corpus); off += chunk {
+				end := off + chunk
+				if end > len(corpus) {
+					end = len(corpus)
+				}
+				chunks = append(chunks, corpus[off:end])
+			}
+
+			fn := codec.compress
+			if *decompress {
+				for i := range chunks {
+					if chunks[i], err = codec.compress(nil, chunks[i]); err != nil {
+						return fmt.Errorf("error: %s: %v", alg, err)
+					}
+				}
+				fn = codec.decompress
+			}
+
+			// warm up the session pool and the software encoders
+			if _, err := fn(nil, chunks[0]); err != nil {
+				return fmt.Errorf("error: %s: %v", alg, err)
+			}
+
+			for _, threads := range threadList {
+				r, err := runBenchCase(fn, chunks, chunk, threads, *loops)
+				if err != nil {
+					return fmt.Errorf("error: %s: %v", alg, err)
+				}
+
+				uncompressed, compressed := r.in, r.out
+				if *decompress {
+					uncompressed, compressed = r.out, r.in
+				}
+				us := func(d time.Duration) float64 { return float64(d) / 1000 }
+				fmt.Printf("%s,%s,%d,%d,%d,%d,%f,%d,%f,%f,%.1f,%.1f,%.1f,%d,%d\n",
+					op, alg, chunk, threads, r.calls, uncompressed,
+					float64(uncompressed)/float64(compressed),
+					r.wallNS/1_000_000,
+					(float64(uncompressed)/1_000_000.0)/(float64(r.wallNS)/1_000_000_000.0),
+					(float64(r.cpuNS)/1_000_000_000.0)/(float64(uncompressed)/1_000_000_000.0),
+					us(r.lat.P50), us(r.lat.P99), us(r.lat.P999),
+					r.exec.HwRequests, r.exec.SwRequests)
+			}
+		}
+	}
+	return nil
+}
+
+// Runs fn over all chunks iterations times on each of threads goroutines
+func runBenchCase(fn benchFunc, chunks [][]byte, chunk int, threads int, iterations int) (r benchResult, err error) {
+	var hist qatzip.LatencyHistogram
+	var mu sync.Mutex
+	var wg sync.WaitGroup
+
+	ru1 := new(syscall.Rusage)
+	ru2 := new(syscall.Rusage)
+	exec1 := qatzip.GetExecStats()
+	syscall.Getrusage(syscall.RUSAGE_SELF, ru1)
+	t1 := time.Now().UnixNano()
+
+	for g := 0; g < threads; g++ {
+		wg.Add(1)
+		go func(g int) {
+			defer wg.Done()
+			dst := make([]byte, 0, 2*chunk+64*1024)
+			for it := 0; it < iterations; it++ {
+				for i := range chunks {
+					// goroutines start at different chunks
+					src := chunks[(i+g)%len(chunks)]
+					t := time.Now()
+					o, cerr := fn(dst, src)
+					hist.Record(time.Since(t))
+					if cerr != nil {
+						mu.Lock()
+						if err == nil {
+							err = cerr
+						}
+						mu.Unlock()
+						return
+					}
+					if cap(o) > cap(dst) {
+						dst = o[:0]
+					}
+					atomic.AddUint64(&r.calls, 1)
+					atomic.AddUint64(&r.in, uint64(len(src)))
+					atomic.AddUint64(&r.out, uint64(len(o)))
+				}
+			}
+		}(g)
+	}
+	wg.Wait()
+
+	t2 := time.Now().UnixNano()
+	syscall.Getrusage(syscall.RUSAGE_SELF, ru2)
+	exec2 := qatzip.GetExecStats()
+
+	r.wallNS = t2 - t1
+	r.cpuNS = ru2.Utime.Nano() - ru1.Utime.Nano() + ru2.Stime.Nano() - ru1.Stime.Nano()
+	r.exec.HwRequests = exec2.HwRequests - exec1.HwRequests
+	r.exec.SwRequests = exec2.SwRequests - exec1.SwRequests
+	r.lat = hist.Snapshot()
+	return r, err
+}
+
+func parseBenchList(s string) (list []int, err error) {
+	for _, f := range strings.Split(s, ",") {
+		n, err := strconv.Atoi(strings.TrimSpace(f))
+		if err != nil || n <= 0 {
+			return nil, fmt.Errorf("error: invalid -bench value %q", f)
+		}
+		list = append(list, n)
+	}
+	return list, nil
+}
+
+// Returns the block codec of a -A algorithm, QAT algorithms use the process-wide session pool
+func newBenchCodec(name string, level int) (c benchCodec, err error) {
+	alg, dfmt := qatzip.DEFLATE, qatzip.DeflateGzipExt
+
+	switch name {
+	case algorithmGzip:
+	case algorithmRawDeflate:
+		dfmt = qatzip.DeflateRaw
+	case algorithmLZ4:
+		alg = qatzip.LZ4
+	case algorithmZstd:
+		alg = qatzip.ZSTD
+
+	case algorithmSWGzip:
+		if _, err = gzip.NewWriterLevel(io.Discard, level); err != nil {
+			return c, err
+		}
+		var readers sync.Pool
+		c.compress = swCompress(func() (swWriter, error) { return gzip.NewWriterLevel(nil, level) })
+		c.decompress = func(dst []byte, src []byte) ([]byte, error) {
+			zr, ok := readers.Get().(*gzip.Reader)
+			var err error
+			if !ok {
+				zr, err = gzip.NewReader(bytes.NewReader(src))
+			} else {
+				err = zr.Reset(bytes.NewReader(src))
+			}
+			if err != nil {
+				return nil, err
+			}
+			defer readers.Put(zr)
+			return readInto(dst, zr)
+		}
+		return c, nil
+	case algorithmSWRawDeflate:
+		if _, err = flate.NewWriter(io.Discard, level); err != nil {
+			return c, err
+		}
+		var readers sync.Pool
+		c.compress = swCompress(func() (swWriter, error) { return flate.NewWriter(nil, level) })
+		c.decompress = func(dst []byte, src []byte) ([]byte, error) {
+			zr, ok := readers.Get().(io.ReadCloser)
+			if !ok {
+				zr = flate.NewReader(bytes.NewReader(src))
+			} else if err := zr.(flate.Resetter).Reset(bytes.NewReader(src), nil); err != nil {
+				return nil, err
+			}
+			defer readers.Put(zr)
+			return readInto(dst, zr)
+		}
+		return c, nil
+	case algorithmSWLZ4:
+		if level < 0 || level > 9 {
+			return c, fmt.Errorf("error: invalid lz4 level %d; valid range [0-9]", level)
+		}
+		levels := []lz4.CompressionLevel{lz4.Fast, lz4.Level1, lz4.Level2, lz4.Level3, lz4.Level4, lz4.Level5,
+			lz4.Level6, lz4.Level7, lz4.Level8, lz4.Level9}
+		var readers sync.Pool
+		c.compress = swCompress(func() (swWriter, error) {
+			zw := lz4.NewWriter(nil)
+			return zw, zw.Apply(lz4.CompressionLevelOption(levels[level]))
+		})
+		c.decompress = func(dst []byte, src []byte) ([]byte, error) {
+			zr, ok := readers.Get().(*lz4.Reader)
+			if !ok {
+				zr = lz4.NewReader(bytes.NewReader(src))
+			} else {
+				zr.Reset(bytes.NewReader(src))
+			}
+			defer readers.Put(zr)
+			return readInto(dst, zr)
+		}
+		return c, nil
+	case algorithmSWZstd:
+		c.compress = func(dst []byte, src []byte) ([]byte, error) { return zstd.CompressLevel(dst[:cap(dst)], src, level) }
+		c.decompress = func(dst []byte, src []byte) ([]byte, error) { return zstd.Decompress(dst[:cap(dst)], src) }
+		return c, nil
+
+	default:
+		return c, fmt.Errorf("error: algorithm %q not supported", name)
+	}
+
+	options := []qatzip.Option{
+		qatzip.CompressionLevelOption(level),
+		qatzip.AlgorithmOption(alg),
+		qatzip.DeflateFmtOption(dfmt),
+		qatzip.DebugLevelOption(qatzip.DebugLevel(*debug)),
+	}
+	c.compress = func(dst []byte, src []byte) ([]byte, error) { return qatzip.CompressBlock(dst, src, options...) }
+	c.decompress = func(dst []byte, src []byte) ([]byte, error) { return qatzip.DecompressBlock(dst, src, options...) }
+	return c, nil
+}
+
+// gzip, flate or lz4 writer
+type swWriter interface {
+	io.WriteCloser
+	Reset(w io.Writer)
+}
+
+// Returns a benchFunc compressing with pooled writers from newWriter
+func swCompress(newWriter func() (swWriter, error)) benchFunc {
+	var writers sync.Pool
+	return func(dst []byte, src []byte) ([]byte, error) {
+		zw, ok := writers.Get().(swWriter)
+		if !ok {
+			var err error
+			if zw, err = newWriter(); err != nil {
+				return nil, err
+			}
+		}
+		buf := bytes.NewBuffer(dst[:0])
+		zw.Reset(buf)
+		_, err := zw.Write(src)
+		if cerr := zw.Close(); err == nil {
+			err = cerr
+		}
+		writers.Put(zw)
+		return buf.Bytes(), err
+	}
+}
+
+// Reads r to the end into dst
+func readInto(dst []byte, r io.Reader) ([]byte, error) {
+	buf := bytes.NewBuffer(dst[:0])
+	_, err := buf.ReadFrom(r)
+	return buf.Bytes(), err
+}
@@ -74,35 +74,72 @@ func compressSWZstd(fin *os.File, fout *os.File, level int) (err error) {
 	return err
 }
 
+// Writer or ParallelWriter
+type qatWriter interface {
+	io.WriteCloser
+	GetPerf() qatzip.Perf
+}
+
 func compressQAT(fin *os.File, fout *os.File, alg qatzip.Algorithm, dfmt qatzip.DeflateFmt) (err error) {
 	r1 := new(syscall.Rusage)
 	r2 := new(syscall.Rusage)
 	syscall.Getrusage(syscall.RUSAGE_SELF, r1)
 	t1 := time.Now().UnixNano()
 
-	z := qatzip.NewWriter(fout)
-
-	err = z.Apply(
-		qatzip.CompressionLevelOption(*level),
-		qatzip.InputBufferModeOption(qatzip.InputBufferMode(*inputBufMode)),
-		qatzip.OutputBufLengthOption(*outputBufSize),
-		qatzip.AlgorithmOption(alg),
-		qatzip.DeflateFmtOption(dfmt),
-		qatzip.DebugLevelOption(qatzip.DebugLevel(*debug)),
-	)
-
-	if err != nil {
-		return err
+	var perf qatzip.Perf
+	t2 := t1
+	if isRegular(fin) {
+		// regular files are memory-mapped by the library, pipes are streamed
+		perf, err = qatzip.CompressFileTo(fout, fin,
+			qatzip.CompressionLevelOption(*level),
+			qatzip.InputBufferModeOption(qatzip.InputBufferMode(*inputBufMode)),
+			qatzip.OutputBufLengthOption(*outputBufSize),
+			qatzip.AlgorithmOption(alg),
+			qatzip.DeflateFmtOption(dfmt),
+			qatzip.WorkersOption(*threads),
+			qatzip.DebugLevelOption(qatzip.DebugLevel(*debug)),
+		)
+	} else {
+		var z qatWriter
+		if *threads > 1 {
+			pz := qatzip.NewParallelWriter(fout)
+			err = pz.Apply(
+				qatzip.CompressionLevelOption(*level),
+				qatzip.AlgorithmOption(alg),
+				qatzip.DeflateFmtOption(dfmt),
+				qatzip.WorkersOption(*threads),
+				qatzip.DebugLevelOption(qatzip.DebugLevel(*debug)),
+			)
+			z = pz
+		} else {
+			sz := qatzip.NewWriter(fout)
+			err = sz.Apply(
+				qatzip.CompressionLevelOption(*level),
+				qatzip.InputBufferModeOption(qatzip.InputBufferMode(*inputBufMode)),
+				qatzip.OutputBufLengthOption(*outputBufSize),
+				qatzip.AlgorithmOption(alg),
+				qatzip.DeflateFmtOption(dfmt),
+				qatzip.DebugLevelOption(qatzip.DebugLevel(*debug)),
+			)
+			z = sz
+		}
+
+		if err != nil {
+			return err
+		}
+
+		t2 = time.Now().UnixNano()
+
+		b := make([]byte, *inputBufSize)
+		// perform compression
+		_, err = io.CopyBuffer(z, fin, b)
+
+		if cerr := z.Close(); err == nil {
+			err = cerr
+		}
+		perf = z.GetPerf()
 	}
 
-	t2 := time.Now().UnixNano()
-
-	b := make([]byte, *inputBufSize)
-	// perform compression
-	_, err = io.CopyBuffer(z, fin, b)
-
-	z.Close()
-
 	t3 := time.Now().UnixNano()
 	syscall.Getrusage(syscall.RUSAGE_SELF, r2)
 
@@ -111,7 +148,7 @@ func compressQAT(fin *os.File, fout *os.File, alg qatzip.Algorithm, dfmt qatzip.
 		fmt.Fprintf(os.Stderr, "User CPU Time %d ms\n", (r2.Utime.Nano()-r1.Utime.Nano())/1_000_000)
 		fmt.Fprintf(os.Stderr, "System CPU Time %d ms\n", (r2.Stime.Nano()-r1.Stime.Nano())/1_000_000)
 		fmt.Fprintf(os.Stderr, "Init Time %d ms\n", (t2-t1)/1_000_000)
-		dumpStats(z.GetPerf(), true)
+		dumpStats(perf, true)
 	}
 
 	if *showStatsCSV && err == nil {
@@ -120,7 +157,7 @@ func compressQAT(fin *os.File, fout *os.File, alg qatzip.Algorithm, dfmt qatzip.
 		fmt.Fprintf(os.Stderr, "%d,", (r2.Utime.Nano()-r1.Utime.Nano())/1_000_000) // User CPU
 		fmt.Fprintf(os.Stderr, "%d,", (r2.Stime.Nano()-r1.Stime.Nano())/1_000_000) // System CPU
 		fmt.Fprintf(os.Stderr, "%d,", (t2-t1)/1_000_000)                           // Init Time
-		dumpStatsCSV(z.GetPerf(), true)
+		dumpStatsCSV(perf, true)
 	}
 
 	return err
@@ -159,35 +196,81 @@ func decompressSWZstd(fin *os.File, fout *os.File) (err error) {
 	return err
 }
 
+// Reports whether f is a regular file
+func isRegular(f *os.File) bool {
+	fi, err := f.Stat()
+	return err == nil && fi.Mode().IsRegular()
+}
+
+// Reader or ParallelReader
+type qatReader interface {
+	io.ReadCloser
+	GetPerf() qatzip.Perf
+}
+
 func decompressQAT(fin *os.File, fout *os.File, alg qatzip.Algorithm, dfmt qatzip.DeflateFmt) (err error) {
 	r1 := new(syscall.Rusage)
 	r2 := new(syscall.Rusage)
 	syscall.Getrusage(syscall.RUSAGE_SELF, r1)
 	t1 := time.Now().UnixNano()
 
-	z, err := qatzip.NewReader(fin)
-	if err != nil {
-		return err
-	}
-
-	err = z.Apply(
-		qatzip.InputBufLengthOption(*inputBufSize),
-		qatzip.OutputBufLengthOption(*outputBufSize),
-		qatzip.AlgorithmOption(alg),
-		qatzip.DeflateFmtOption(dfmt),
-		qatzip.DebugLevelOption(qatzip.DebugLevel(*debug)),
-	)
-
-	if err != nil {
-		return err
+	var perf qatzip.Perf
+	t2 := t1
+	if isRegular(fin) {
+		// regular files are memory-mapped by the library, pipes are streamed
+		perf, err = qatzip.DecompressFileTo(fout, fin,
+			qatzip.InputBufLengthOption(*inputBufSize),
+			qatzip.OutputBufLengthOption(*outputBufSize),
+			qatzip.AlgorithmOption(alg),
+			qatzip.DeflateFmtOption(dfmt),
+			qatzip.WorkersOption(*threads),
+			qatzip.DebugLevelOption(qatzip.DebugLevel(*debug)),
+		)
+	} else {
+		var z qatReader
+		if *threads > 1 {
+			pz, err := qatzip.NewParallelReader(fin)
+			if err != nil {
+				return err
+			}
+			err = pz.Apply(
+				qatzip.InputBufLengthOption(*inputBufSize),
+				qatzip.OutputBufLengthOption(*outputBufSize),
+				qatzip.AlgorithmOption(alg),
+				qatzip.DeflateFmtOption(dfmt),
+				qatzip.WorkersOption(*threads),
+				qatzip.DebugLevelOption(qatzip.DebugLevel(*debug)),
+			)
+			if err != nil {
+				return err
+			}
+			z = pz
+		} else {
+			sz, err := qatzip.NewReader(fin)
+			if err != nil {
+				return err
+			}
+			err = sz.Apply(
+				qatzip.InputBufLengthOption(*inputBufSize),
+				qatzip.OutputBufLengthOption(*outputBufSize),
+				qatzip.AlgorithmOption(alg),
+				qatzip.DeflateFmtOption(dfmt),
+				qatzip.DebugLevelOption(qatzip.DebugLevel(*debug)),
+			)
+			if err != nil {
+				return err
+			}
+			z = sz
+		}
+
+		t2 = time.Now().UnixNano()
+
+		// perform decompression
+		_, err = io.Copy(fout, z)
+		z.Close()
+		perf = z.GetPerf()
 	}
 
-	t2 := time.Now().UnixNano()
-
-	// perform decompression
-	_, err = io.Copy(fout, z)
-	z.Close()
-
 	t3 := time.Now().UnixNano()
 	syscall.Getrusage(syscall.RUSAGE_SELF, r2)
 
@@ -196,7 +279,7 @@ func decompressQAT(fin *os.File, fout *os.File, alg qatzip.Algorithm, dfmt qatzi
 		fmt.Fprintf(os.Stderr, "User CPU Time %d ms\n", (r2.Utime.Nano()-r1.Utime.Nano())/1_000_000)
 		fmt.Fprintf(os.Stderr, "System CPU Time %d ms\n", (r2.Stime.Nano()-r1.Stime.Nano())/1_000_000)
 		fmt.Fprintf(os.Stderr, "Init Time %d ms\n", (t2-t1)/1_000_000)
-		dumpStats(z.GetPerf(), false)
+		dumpStats(perf, false)
 	}
 
 	if *showStatsCSV && err == nil {
@@ -205,7 +288,7 @@ func decompressQAT(fin *os.File, fout *os.File, alg qatzip.Algorithm, dfmt qatzi
 		fmt.Fprintf(os.Stderr, "%d,", (r2.Utime.Nano()-r1.Utime.Nano())/1_000_000) // User CPU
 		fmt.Fprintf(os.Stderr, "%d,", (r2.Stime.Nano()-r1.Stime.Nano())/1_000_000) // System CPU
 		fmt.Fprintf(os.Stderr, "%d,", (t2-t1)/1_000_000)                           // Init Time
-		dumpStatsCSV(z.GetPerf(), false)
+		dumpStatsCSV(perf, false)
 	}
 
 	return err
@@ -218,6 +301,9 @@ func dumpStats(perf qatzip.Perf, compress bool) {
 	fmt.Fprintf(os.Stderr, "Write Time  %d ms\n", perf.WriteTimeNS/1_000_000)
 	fmt.Fprintf(os.Stderr, "Engine Time %d ms\n", perf.EngineTimeNS/1_000_000)
 	fmt.Fprintf(os.Stderr, "Copy Time %d ms\n", perf.CopyTimeNS/1_000_000)
+	fmt.Fprintf(os.Stderr, "HW Requests %d\n", perf.HwRequests)
+	fmt.Fprintf(os.Stderr, "SW Requests %d (small %d, backoff %d)\n", perf.SwRequests, perf.SwSmallRequests, perf.SwBackoffRequests)
+	fmt.Fprintf(os.Stderr, "HW Fallbacks %d, Retries %d\n", perf.HwFallbacks, perf.HwRetries)
 
 	if compress {
 		fmt.Fprintf(os.Stderr, "Compression Ratio %f\n", float64(perf.BytesIn)/float64(perf.BytesOut))
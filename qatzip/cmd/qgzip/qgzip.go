@@ -9,6 +9,8 @@ Usage:
 
 The flags are:
 
+	  -T int
+	        compress or decompress with n QATzip sessions in parallel (default 1)
 	  -A string
 	        algorithm (default "gzip")
 			"gzip" QATzip DEFLATE/gzip
@@ -20,6 +22,16 @@ The flags are:
 			"sw_raw" stdlib compress/flate
 			"sw_zstd" DataDog/zstd
 
+	  -bench
+	        benchmark in-memory block compression of the input files (or stdin),
+	        -loop passes per goroutine, -d benchmarks decompression; prints CSV of
+	        throughput, ratio, CPU time per GB and p50/p99/p999 call latency
+	  -bench_algs string
+	        comma separated algorithms for -bench (default -A)
+	  -bench_chunks string
+	        comma separated chunk sizes for -bench (default "65536")
+	  -bench_threads string
+	        comma separated numbers of goroutines for -bench (default "1")
 	  -c    output to stdout
 	  -csv
 	        show performance stats in CSV
@@ -100,6 +112,7 @@ var (
 	loops         = flag.Int("loop", 1, "repeat command n times")
 	inputBufMode  = flag.Int("ibm", 0, "input buffer mode setting")
 	test          = flag.Bool("t", false, "test decompression of file")
+	threads       = flag.Int("T", 1, "compress or decompress with n QATzip sessions in parallel")
 )
 
 var wg sync.WaitGroup
@@ -162,10 +175,22 @@ func main() {
 		defer trace.Stop()
 	}
 
+	if *threads <= 0 {
+		log.Fatalf("error: invalid number of threads T=%v", *threads)
+	}
+
 	if *inputBufSize <= 0 || *outputBufSize <= 0 {
 		log.Fatalf("error: invalid buffersize ibs=%v obs=%v", *inputBufSize, *outputBufSize)
 	}
 
+	if *bench {
+		if err := runBench(fileList); err != nil {
+			fmt.Fprintf(os.Stderr, "%v\n", err)
+			errExitCode = 1
+		}
+		return
+	}
+
 	if len(fileList) == 0 {
 		*pipeOut = true
 	}
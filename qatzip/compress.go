@@ -16,18 +16,23 @@ import (
 
 // Writer implements an io.Writer. When written to, it sends compressed content to w.
 type Writer struct {
-	w            io.Writer
-	closed       bool
-	wroteHeader  bool
-	err          error
-	q            *QzBinding // internal QAT state
-	bounceBuf    []byte
-	outputBuf    *bytes.Buffer
-	bufferGrowth int
-	p            params
-	ctx          context.Context // context for tracing
-	task         *trace.Task     // task for tracing
-	perf         *Perf           // perfomance counters
+	w               io.Writer
+	closed          bool
+	wroteHeader     bool
+	err             error
+	q               *QzBinding // internal QAT state
+	bounceBuf       []byte
+	outputBuf       *bytes.Buffer
+	bufferGrowth    int
+	outputBufLength int // size of pipelined output buffers
+	p               params
+	ctx             context.Context // context for tracing
+	task            *trace.Task     // task for tracing
+	perf            *Perf           // perfomance counters
+	pipe            *writePipeline  // asynchronous output writer (PipelineDepth > 0)
+	readFromBuf     [2][]byte       // input buffers for ReadFrom
+	frameOpen       bool            // ZSTD frame started with last=false has not been ended
+	unterminated    bool            // data compressed with last=false has not been followed by a final block
 }
 
 const (
@@ -52,14 +57,23 @@ const (
 	lz4Magic4 uint8  = 0x02
 )
 
+const (
+	defaultHwBufSize  = 64 * 1024 // QATzip default hardware buffer size
+	readFromHwBuffers = 64        // hardware buffers per ReadFrom input buffer
+	minGzipSize       = 1024      // DEFLATE inputs QATzip compresses as final regardless of last (MIN_GZIP_SIZE)
+)
+
 // Performance counters
 type Perf struct {
-	ReadTimeNS   uint64 // time (ns) spent reading from r
-	WriteTimeNS  uint64 // time (ns) spent writing to w
-	BytesIn      uint64 // bytes sent to QATzip
-	BytesOut     uint64 // bytes received from QATzip
-	EngineTimeNS uint64 // time (ns) spent in QATzip
-	CopyTimeNS   uint64 // time (ns) spent copying buffers + reallocation
+	ReadTimeNS     uint64 // time (ns) spent reading from r, with read-ahead the time spent waiting for prefetched input
+	PrefetchTimeNS uint64 // time (ns) the read-ahead goroutine spent reading from r, overlapped with decompression
+	WriteTimeNS    uint64 // time (ns) spent writing to w
+	BytesIn        uint64 // bytes sent to QATzip
+	BytesOut       uint64 // bytes received from QATzip
+	BytesStored    uint64 // bytes of BytesIn stored uncompressed without a QATzip request
+	EngineTimeNS   uint64 // time (ns) spent in QATzip
+	CopyTimeNS     uint64 // time (ns) spent copying buffers + reallocation
+	ExecStats             // requests executed in hardware and software
 }
 
 // NewWriter creates a new Writer with output io.Writer w
@@ -78,14 +92,13 @@ func NewWriterLevel(w io.Writer, level int) (z *Writer, err error) {
 	return
 }
 
-// Writes an empty header and footer for gzip and lz4
+// Returns an empty compressed stream (header and footer) for the configured algorithm
 // This is a workaround due to QATzip not supporting empty files
-func (z *Writer) writeEmptyBuffer() (err error) {
-	var buf []byte
+func emptyStream(p params) (buf []byte, err error) {
 	var le = binary.LittleEndian
-	switch z.p.Algorithm {
+	switch p.Algorithm {
 	case DEFLATE:
-		hdr := [10]byte{0: gzipID1, 1: gzipID2, 2: gzipDeflate, 8: byte(z.p.Level), 9: osType}
+		hdr := [10]byte{0: gzipID1, 1: gzipID2, 2: gzipDeflate, 8: byte(p.Level), 9: osType}
 		magic := [5]byte{0: deflateMagic1, 3: deflateMagic2, 4: deflateMagic2}
 		ftr := [8]byte{}
 		buf = append(hdr[:], magic[:]...)
@@ -100,16 +113,25 @@ func (z *Writer) writeEmptyBuffer() (err error) {
 		buf = append(buf, end[:]...)
 		buf = append(buf, magic[:]...)
 	case ZSTD:
-		_, err := zstd.Compress(buf, buf)
+		buf, err = zstd.Compress(nil, nil)
 		if err != nil {
-			err = ErrFail
-			return err
+			return nil, ErrFail
 		}
 	default:
-		err = ErrUnsupportedFmt
+		return nil, ErrUnsupportedFmt
+	}
+	return buf, nil
+}
+
+// Writes an empty header and footer for the configured algorithm
+func (z *Writer) writeEmptyBuffer() (err error) {
+	buf, err := emptyStream(z.p)
+	if err != nil {
 		return err
 	}
-	z.traceLogf(Med, "[write->output] header/footer")
+	if z.traceOn(Med) {
+		z.traceLogf(Med, "[write->output] header/footer")
+	}
 	_, err = z.w.Write(buf)
 	z.wroteHeader = true
 	return err
@@ -122,38 +144,61 @@ func (z *Writer) Close() (err error) {
 		return
 	}
 
-	z.traceLogf(Med, "[close] err:'%v'", z.err)
+	if z.traceOn(Med) {
+		z.traceLogf(Med, "[close] err:'%v'", z.err)
+	}
+
+	defer z.task.End()
+	defer metricsAddStream(z.perf)
 
 	if z.err != nil {
+		// the session is in an unknown state and is not returned to the pool
+		z.closed = true
+		z.stopPipeline()
+		z.q.Close()
 		return z.err
 	}
 
-	defer z.task.End()
-
 	if !z.wroteHeader && z.perf.BytesIn == 0 && len(z.bounceBuf) == 0 {
-		r := trace.StartRegion(z.ctx, "Qz(5) Empty Buffer")
+		r := startRegion(z.ctx, "Qz(5) Empty Buffer")
 		z.err = z.writeEmptyBuffer()
-		r.End()
+		endRegion(r)
 		if z.err != nil {
+			z.closed = true
+			z.stopPipeline()
+			z.q.Close()
 			return z.err
 		}
 	}
 
 	z.closed = true
 
-	r := trace.StartRegion(z.ctx, "Qz(4) Last Write")
-	defer r.End()
+	r := startRegion(z.ctx, "Qz(4) Last Write")
+	defer endRegion(r)
 
 	if z.err == nil {
+		// a stream left without a final block by Flush or DeferLast is terminated here
 		z.q.SetLast(true)
 		err := z.flushBounceBuffer()
+		if err == nil && (z.frameOpen || z.unterminated && z.p.InputBufferMode != NoLast) {
+			if err = z.writeFinalBlock(); err != nil {
+				z.err = err
+			}
+		}
 		if err != nil {
+			z.stopPipeline()
 			z.q.Close()
 			return z.err
 		}
 	}
 
-	z.err = z.q.Close()
+	if err = z.stopPipeline(); err != nil {
+		z.err = err
+		z.q.Close()
+		return z.err
+	}
+
+	z.err = releaseSession(z.q)
 
 	if z.err != nil {
 		return z.err
@@ -165,35 +210,69 @@ func (z *Writer) Close() (err error) {
 // Reset discards current state, loads applied options, and restarts session
 func (z *Writer) Reset(w io.Writer) (err error) {
 	z.Close()
+	z.err = nil
 	z.ctx, z.task = trace.NewTask(context.Background(), "Qz io.Writer")
 
 	if z.p.DebugLevel == None {
 		z.p.DebugLevel = getTraceLevel()
 	}
 
-	z.q, err = NewQzBinding()
+	z.q, err = acquireSession(z.p)
 	if err != nil {
 		z.err = err
 		return
 	}
-	z.q.setParams(z.p)
-	if err = z.q.StartSession(); err != nil {
-		z.err = err
-		return
+
+	z.outputBufLength = z.p.OutputBufLength
+	if z.outputBufLength > z.p.MaxBufferLength {
+		z.outputBufLength = z.p.MaxBufferLength
 	}
 
-	z.outputBuf = bytes.NewBuffer(make([]byte, z.p.OutputBufLength))
+	if z.p.PipelineDepth == 0 {
+		z.outputBuf = bytes.NewBuffer(getBuffer(z.outputBufLength))
+	}
 
 	z.w = w
 	z.closed = false
 	z.wroteHeader = false
+	z.frameOpen = false
+	z.unterminated = false
 	z.bufferGrowth = z.p.BufferGrowth
 	z.bounceBuf = make([]byte, 0, z.p.BounceBufferLength)
 	z.perf = new(Perf)
+	z.q.perf = z.perf
+
+	if z.p.PipelineDepth > 0 {
+		z.pipe = newWritePipeline(z.ctx, w, z.p.PipelineDepth)
+	}
 
 	return
 }
 
+// Waits for pipelined writes to complete and collects the write time, output and ReadFrom buffers are returned
+// to the buffer pool
+func (z *Writer) stopPipeline() (err error) {
+	if z.outputBuf != nil {
+		putBuffer(z.outputBuf.Bytes())
+		z.outputBuf = nil
+	}
+	for i, b := range z.readFromBuf {
+		if b != nil {
+			putBuffer(b)
+			z.readFromBuf[i] = nil
+		}
+	}
+
+	if z.pipe == nil {
+		return nil
+	}
+
+	wt, err := z.pipe.close()
+	z.perf.WriteTimeNS += wt
+	z.pipe = nil
+	return err
+}
+
 // Write() inputs data from p and writes compressed output data io.Writer w
 func (z *Writer) Write(p []byte) (n int, err error) {
 	if z.err != nil {
@@ -204,10 +283,12 @@ func (z *Writer) Write(p []byte) (n int, err error) {
 		if z.err = z.Reset(z.w); z.err != nil {
 			return 0, z.err
 		}
+	} else if z.closed {
+		return 0, ErrWriterClosed
 	}
 
-	r := trace.StartRegion(z.ctx, "Qz(1) Write()")
-	defer r.End()
+	r := startRegion(z.ctx, "Qz(1) Write()")
+	defer endRegion(r)
 
 	b := p
 	nw := 0
@@ -222,7 +303,7 @@ func (z *Writer) Write(p []byte) (n int, err error) {
 	if z.p.InputBufferMode != NoLast {
 		if z.p.InputBufferMode == Bounce || len(p) <= z.p.BounceBufferLength {
 			t1 := time.Now().UnixNano()
-			if len(p) > len(z.bounceBuf) {
+			if len(p) > cap(z.bounceBuf) {
 				z.bounceBuf = make([]byte, 0, len(p))
 			}
 
@@ -256,6 +337,122 @@ func (z *Writer) Write(p []byte) (n int, err error) {
 	return
 }
 
+// ReadFrom reads data from r until EOF directly into QAT sized input buffers (at most MaxBufferLength)
+// and compresses it. The tail of the input is held back in the bounce buffer and compressed with last=true by Close.
+func (z *Writer) ReadFrom(r io.Reader) (n int64, err error) {
+	if z.err != nil {
+		return 0, z.err
+	}
+
+	if z.q == nil {
+		if z.err = z.Reset(z.w); z.err != nil {
+			return 0, z.err
+		}
+	} else if z.closed {
+		return 0, ErrWriterClosed
+	}
+
+	rr := startRegion(z.ctx, "Qz(1) ReadFrom()")
+	defer endRegion(rr)
+
+	if err = z.flushBounceBuffer(); err != nil {
+		return 0, err
+	}
+
+	length := minInt(z.p.hwBufSize()*readFromHwBuffers, z.p.MaxBufferLength)
+	for i := range z.readFromBuf {
+		if len(z.readFromBuf[i]) != length {
+			if z.readFromBuf[i] != nil {
+				putBuffer(z.readFromBuf[i])
+			}
+			z.readFromBuf[i] = getBuffer(length)
+		}
+	}
+
+	cur := 0
+	nr, err := z.readChunk(r, z.readFromBuf[cur])
+	for nr > 0 && err == nil {
+		n += int64(nr)
+
+		// read ahead so the final chunk can be compressed with last=true
+		next := 1 - cur
+		nn, rerr := z.readChunk(r, z.readFromBuf[next])
+		if nn == 0 {
+			// the tail is held back in the bounce buffer
+			tail := nr - minInt(nr, z.p.BounceBufferLength)
+			if tail > 0 {
+				if _, err = z.compressWrite(z.readFromBuf[cur][:tail]); err != nil {
+					return n, err
+				}
+			}
+			z.bounceBuf = append(z.bounceBuf[:0], z.readFromBuf[cur][tail:nr]...)
+			return n, rerr
+		}
+
+		if _, err = z.compressWrite(z.readFromBuf[cur][:nr]); err != nil {
+			return n, err
+		}
+		cur, nr, err = next, nn, rerr
+	}
+
+	return n, err
+}
+
+// Flush compresses buffered input and writes all compressed data to w without ending the stream,
+// so that a reader can decompress everything written so far. ZSTD flushes its frame (ZSTD_e_flush),
+// DEFLATE and LZ4 already emit each compressed buffer as complete blocks.
+func (z *Writer) Flush() (err error) {
+	if z.err != nil {
+		return z.err
+	}
+
+	if z.q == nil {
+		return nil
+	} else if z.closed {
+		return ErrWriterClosed
+	}
+
+	r := startRegion(z.ctx, "Qz(6) Flush")
+	defer endRegion(r)
+
+	if err = z.flushBounceBuffer(); err != nil {
+		return err
+	}
+
+	if z.frameOpen {
+		if err = z.drainZstd(z.q.flush); err != nil {
+			z.err = err
+			return err
+		}
+	}
+
+	if z.pipe != nil {
+		if err = z.pipe.flush(); err != nil {
+			z.err = err
+		}
+	}
+
+	return err
+}
+
+// Fills b from r, returns a short count only at the end of the input
+func (z *Writer) readChunk(r io.Reader, b []byte) (n int, err error) {
+	rr := startRegion(z.ctx, "Qz(0) Input Stream")
+	t1 := time.Now().UnixNano()
+	n, err = io.ReadFull(r, b)
+	t2 := time.Now().UnixNano()
+	z.perf.ReadTimeNS += uint64(t2 - t1)
+	endRegion(rr)
+
+	if err == io.EOF || err == io.ErrUnexpectedEOF {
+		err = nil
+	}
+	if err != nil {
+		z.err = err
+	}
+	return n, err
+}
+
 func (z *Writer) flushBounceBuffer() (err error) {
 	if len(z.bounceBuf) > 0 {
 		nw, err := z.compressWrite(z.bounceBuf)
@@ -273,8 +470,85 @@ func (z *Writer) flushBounceBuffer() (err error) {
 	return
 }
 
-// Compresses transfer buffer
+// Compresses transfer buffer, incompressible segments are stored if StoreIncompressible is set
 func (z *Writer) compressWrite(p []byte) (n int, err error) {
+	if z.p.StoreIncompressible == 0 || !storeSupported(z.p) {
+		return z.qatWrite(p)
+	}
+
+	err = storeRuns(p, func(run []byte, stored bool) (err error) {
+		var nr int
+		// a stored frame cannot be inserted into an open ZSTD frame, which is ended first
+		if stored && z.frameOpen {
+			if err = z.endFrame(); err != nil {
+				return err
+			}
+		}
+		if stored {
+			nr, err = z.storeWrite(run)
+		} else {
+			nr, err = z.qatWrite(run)
+		}
+		n += nr
+		return err
+	})
+	return n, err
+}
+
+// Ends the ZSTD frame open on the session, later input starts a new frame
+func (z *Writer) endFrame() (err error) {
+	last := z.q.isLast()
+	err = z.drainZstd(z.q.finish)
+	z.q.SetLast(last)
+	if err != nil {
+		z.err = err
+		return err
+	}
+	z.frameOpen = false
+	z.unterminated = false
+	return nil
+}
+
+// Writes p as stored members/frames without sending it to QATzip
+func (z *Writer) storeWrite(p []byte) (n int, err error) {
+	if z.err != nil {
+		return 0, z.err
+	}
+
+	for n < len(p) {
+		outputBuf, err := z.getOutputBuffer()
+		if err != nil {
+			z.err = err
+			return n, err
+		}
+
+		// the stored overhead of half a buffer is far less than the other half
+		t1 := time.Now().UnixNano()
+		chunk := p[n:minInt(n+len(outputBuf)/2, len(p))]
+		produced := len(appendStored(z.p, outputBuf[:0], chunk))
+		t2 := time.Now().UnixNano()
+		z.perf.CopyTimeNS += uint64(t2 - t1)
+		z.perf.BytesIn += uint64(len(chunk))
+		z.perf.BytesOut += uint64(produced)
+		z.perf.BytesStored += uint64(len(chunk))
+		z.wroteHeader = true
+		n += len(chunk)
+
+		if z.traceOn(Med) {
+			z.traceLogf(Med, "[write->store] i:%v o:%v", len(chunk), produced)
+		}
+
+		if err = z.emit(outputBuf, produced); err != nil {
+			z.err = err
+			return n, err
+		}
+	}
+
+	return n, nil
+}
+
+// Compresses p on the QATzip session
+func (z *Writer) qatWrite(p []byte) (n int, err error) {
 	var t1, t2 int64 // for performance counters
 
 	if z.err != nil {
@@ -289,52 +563,93 @@ func (z *Writer) compressWrite(p []byte) (n int, err error) {
 		if z.p.InputBufferMode == Last {
 			z.q.SetLast(true)
 		}
+
+		outputBuf, err := z.getOutputBuffer()
+		if err != nil {
+			z.err = err
+			return consumed, err
+		}
+
+		// ZSTD requires room for the compressed size bound of its input
+		chunk := p[consumed:]
+		if z.p.Algorithm == ZSTD {
+			if n := maxInputLength(ZSTD, len(outputBuf)); n > 0 && n < len(chunk) {
+				chunk = chunk[:n]
+			}
+		}
+
 		// compress input data
-		r := trace.StartRegion(z.ctx, "Qz(2) Compress")
+		r := startRegion(z.ctx, "Qz(2) Compress")
 		t1 = time.Now().UnixNano()
-		in, out, err := z.q.Compress(p[consumed:], z.outputBuf.Bytes())
+		in, out, err := z.q.Compress(chunk, outputBuf)
 		if err == nil {
-			z.perf.BytesIn += uint64(len(p) - consumed)
+			z.perf.BytesIn += uint64(in)
 			z.perf.BytesOut += uint64(out)
 			t2 = time.Now().UnixNano()
 			z.perf.EngineTimeNS += uint64(t2 - t1)
 		}
-		r.End()
+		endRegion(r)
 
-		z.traceLogf(Med, "[write->qat] r:%v i:%v o:%v ibofs:%v obl:%v err:%v", remainder, in, out, consumed, z.outputBuf.Len(), err)
+		if z.traceOn(Med) {
+			z.traceLogf(Med, "[write->qat] r:%v i:%v o:%v ibofs:%v obl:%v err:%v", remainder, in, out, consumed, len(outputBuf), err)
+		}
 
 		if err != nil {
 			if err == ErrBuffer {
-				// expand output buffer
-				// TODO grow to a maximum size
+				// expand output buffer up to MaxBufferLength
+				if len(outputBuf) >= z.p.MaxBufferLength {
+					if z.pipe != nil {
+						z.pipe.put(outputBuf)
+					}
+					z.err = err
+					return consumed, err
+				}
 				t1 = time.Now().UnixNano()
 				z.bufferGrowth *= 2
 				newSize := remainder + z.bufferGrowth
-				z.traceLogf(Med, "[expand output buffer] o:%v n:%v", z.outputBuf.Len(), newSize)
-				z.outputBuf = bytes.NewBuffer(make([]byte, newSize))
+				if newSize <= len(outputBuf) {
+					newSize = len(outputBuf) + z.bufferGrowth
+				}
+				if newSize > z.p.MaxBufferLength {
+					newSize = z.p.MaxBufferLength
+				}
+				if z.traceOn(Med) {
+					z.traceLogf(Med, "[expand output buffer] o:%v n:%v", len(outputBuf), newSize)
+				}
+				if z.pipe != nil {
+					z.outputBufLength = newSize
+					z.pipe.put(outputBuf)
+				} else {
+					putBuffer(outputBuf)
+					z.outputBuf = bytes.NewBuffer(getBuffer(newSize))
+				}
 				t2 = time.Now().UnixNano()
 				z.perf.CopyTimeNS += uint64(t2 - t1)
 				continue
 			}
+			if z.pipe != nil {
+				z.pipe.put(outputBuf)
+			}
 			z.err = err
 			return consumed, err
 		}
 		z.wroteHeader = true
+		z.unterminated = !z.q.isLast() && (z.p.Algorithm != DEFLATE || len(chunk) > minGzipSize)
+		if z.p.Algorithm == ZSTD {
+			z.frameOpen = z.unterminated
+		}
 		consumed += in
 		remainder -= in
 		produced = out
 
-		if produced > 0 {
-			r := trace.StartRegion(z.ctx, "Qz(3) Output Stream")
-			t1 = time.Now().UnixNano()
-			nw, err := z.w.Write(z.outputBuf.Bytes()[:produced])
-			t2 = time.Now().UnixNano()
-			z.perf.WriteTimeNS += uint64(t2 - t1)
-			r.End()
-
-			z.traceLogf(Med, "[write->output] nw:%v err:%v", nw, err)
+		if err = z.emit(outputBuf, produced); err != nil {
+			z.err = err
+			return consumed, err
+		}
 
-			if err != nil {
+		// a multithreaded ZSTD frame may end with more output than fits in one buffer
+		if z.p.Algorithm == ZSTD && z.q.isLast() && z.q.Pending() {
+			if err = z.drainZstd(z.q.finish); err != nil {
 				z.err = err
 				return consumed, err
 			}
@@ -344,8 +659,101 @@ func (z *Writer) compressWrite(p []byte) (n int, err error) {
 	return consumed, nil
 }
 
+// Sends produced bytes of outputBuf to the output stream, in pipelined mode outputBuf is handed to the pipeline
+func (z *Writer) emit(outputBuf []byte, produced int) (err error) {
+	if z.pipe != nil {
+		if produced > 0 {
+			z.pipe.submit(outputBuf[:produced])
+		} else {
+			z.pipe.put(outputBuf)
+		}
+		return nil
+	}
+
+	if produced > 0 {
+		r := startRegion(z.ctx, "Qz(3) Output Stream")
+		t1 := time.Now().UnixNano()
+		nw, err := z.w.Write(outputBuf[:produced])
+		t2 := time.Now().UnixNano()
+		z.perf.WriteTimeNS += uint64(t2 - t1)
+		endRegion(r)
+
+		if z.traceOn(Med) {
+			z.traceLogf(Med, "[write->output] nw:%v err:%v", nw, err)
+		}
+		return err
+	}
+
+	return nil
+}
+
+// Terminates a stream whose data was compressed with last=false (Flush, DeferLast).
+// ZSTD ends the frame, DEFLATE and LZ4 append an empty final block, member or frame.
+func (z *Writer) writeFinalBlock() (err error) {
+	var tail []byte
+
+	switch {
+	case z.p.Algorithm == ZSTD:
+		return z.drainZstd(z.q.finish)
+	case z.p.DataFmtDeflate == DeflateRaw && z.p.Algorithm == DEFLATE:
+		tail = []byte{deflateMagic1, 0, 0, deflateMagic2, deflateMagic2}
+	case z.p.DataFmtDeflate == Deflate48 && z.p.Algorithm == DEFLATE:
+		tail = []byte{5, 0, 0, 0, deflateMagic1, 0, 0, deflateMagic2, deflateMagic2}
+	default:
+		if tail, err = emptyStream(z.p); err != nil {
+			return err
+		}
+	}
+
+	outputBuf, err := z.getOutputBuffer()
+	if err != nil {
+		return err
+	}
+	produced := copy(outputBuf, tail)
+	z.perf.BytesOut += uint64(produced)
+	if z.traceOn(Med) {
+		z.traceLogf(Med, "[write->output] final block")
+	}
+	return z.emit(outputBuf, produced)
+}
+
+// Writes the output of a ZSTD session ending (finish) or flushing (flush) a frame until none is pending
+func (z *Writer) drainZstd(step func(out []byte) (int, error)) (err error) {
+	for {
+		outputBuf, err := z.getOutputBuffer()
+		if err != nil {
+			return err
+		}
+		t1 := time.Now().UnixNano()
+		produced, err := step(outputBuf)
+		t2 := time.Now().UnixNano()
+		z.perf.EngineTimeNS += uint64(t2 - t1)
+		if err != nil {
+			if z.pipe != nil {
+				z.pipe.put(outputBuf)
+			}
+			return err
+		}
+		z.perf.BytesOut += uint64(produced)
+		if err = z.emit(outputBuf, produced); err != nil || !z.q.Pending() {
+			return err
+		}
+	}
+}
+
+// Returns the buffer to compress into, in pipelined mode a free buffer from the pipeline
+func (z *Writer) getOutputBuffer() ([]byte, error) {
+	if z.pipe == nil {
+		return z.outputBuf.Bytes(), nil
+	}
+	return z.pipe.get(z.outputBufLength)
+}
+
 // Get performance counters from Writer
 func (z *Writer) GetPerf() Perf {
+	if z.q != nil && !z.closed {
+		z.q.collectStats()
+	}
 	return *z.perf
 }
 
@@ -0,0 +1,125 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+package qatzip
+
+import (
+	"hash/crc32"
+	"hash/crc64"
+)
+
+// ChecksumKind selects the checksum computed by Checksum
+type ChecksumKind int
+
+const (
+	CRC32  ChecksumKind = iota // CRC-32 (IEEE), as in gzip trailers
+	CRC32C                     // CRC-32C (Castagnoli)
+	CRC64                      // CRC-64 (ECMA-182), as in xz
+)
+
+var (
+	castagnoliTable = crc32.MakeTable(crc32.Castagnoli)
+	ecmaTable       = crc64.MakeTable(crc64.ECMA)
+)
+
+// Reversed polynomial and width of the checksum
+func (k ChecksumKind) poly() (poly uint64, width int, ok bool) {
+	switch k {
+	case CRC32:
+		return crc32.IEEE, 32, true
+	case CRC32C:
+		return crc32.Castagnoli, 32, true
+	case CRC64:
+		return crc64.ECMA, 64, true
+	}
+	return 0, 0, false
+}
+
+// Checksum returns the checksum of data. QATzip computes CRCs only while compressing (CompressCRC),
+// standalone checksums use hash/crc32, which runs on the CPU's CRC and carry-less multiply
+// instructions where available, and hash/crc64.
+func Checksum(data []byte, kind ChecksumKind) (uint64, error) {
+	switch kind {
+	case CRC32:
+		return uint64(crc32.ChecksumIEEE(data)), nil
+	case CRC32C:
+		return uint64(crc32.Checksum(data, castagnoliTable)), nil
+	case CRC64:
+		return crc64.Checksum(data, ecmaTable), nil
+	}
+	return 0, ErrParamChecksum
+}
+
+// ChecksumCombine returns the checksum of A followed by B given crc1 = Checksum(A), crc2 = Checksum(B)
+// and len2 = len(B), without access to the data
+func ChecksumCombine(kind ChecksumKind, crc1 uint64, crc2 uint64, len2 int64) (uint64, error) {
+	poly, width, ok := kind.poly()
+	if !ok {
+		return 0, ErrParamChecksum
+	}
+	return crcCombine(poly, width, crc1, crc2, len2), nil
+}
+
+// CRC32Combine returns the CRC-32 (IEEE) of A followed by B given crc1 = CRC(A), crc2 = CRC(B) and len2 = len(B)
+func CRC32Combine(crc1 uint32, crc2 uint32, len2 int64) uint32 {
+	return uint32(crcCombine(crc32.IEEE, 32, uint64(crc1), uint64(crc2), len2))
+}
+
+// GF(2) matrix helpers for combining CRCs (see zlib crc32_combine)
+func gf2MatrixTimes(mat []uint64, vec uint64) (sum uint64) {
+	for i := 0; vec != 0; i, vec = i+1, vec>>1 {
+		if vec&1 != 0 {
+			sum ^= mat[i]
+		}
+	}
+	return sum
+}
+
+func gf2MatrixSquare(square []uint64, mat []uint64) {
+	for n := range square {
+		square[n] = gf2MatrixTimes(mat, mat[n])
+	}
+}
+
+// Combines two reflected CRCs of width bits with reversed polynomial poly
+func crcCombine(poly uint64, width int, crc1 uint64, crc2 uint64, len2 int64) uint64 {
+	var evenRows, oddRows [64]uint64
+
+	if len2 <= 0 {
+		return crc1
+	}
+	even, odd := evenRows[:width], oddRows[:width]
+
+	// operator for one zero bit in odd
+	odd[0] = poly
+	row := uint64(1)
+	for n := 1; n < width; n++ {
+		odd[n] = row
+		row <<= 1
+	}
+
+	gf2MatrixSquare(even, odd) // two zero bits
+	gf2MatrixSquare(odd, even) // four zero bits
+
+	// apply len2 zeros to crc1
+	for {
+		gf2MatrixSquare(even, odd)
+		if len2&1 != 0 {
+			crc1 = gf2MatrixTimes(even, crc1)
+		}
+		len2 >>= 1
+		if len2 == 0 {
+			break
+		}
+
+		gf2MatrixSquare(odd, even)
+		if len2&1 != 0 {
+			crc1 = gf2MatrixTimes(odd, crc1)
+		}
+		len2 >>= 1
+		if len2 == 0 {
+			break
+		}
+	}
+
+	return crc1 ^ crc2
+}
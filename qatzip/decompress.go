@@ -23,11 +23,13 @@ type Reader struct {
 	outputBufOffset int
 	outputBufLeft   int
 	streamDone      bool
+	nested          bool // Perf is reported by the owning ParallelReader
 	bufferGrowth    int
 	p               params
 	ctx             context.Context // context for tracing
 	task            *trace.Task     // task for tracing
 	perf            *Perf           // performance counters
+	ahead           *readPipeline   // input prefetched by a reader goroutine (ReadAheadDepth > 0)
 }
 
 // NewReader creates a new Reader with input io.Reader r
@@ -45,26 +47,51 @@ func (z *Reader) Close() error {
 		return z.err
 	}
 
-	z.traceLogf(Med, "[close] err:'%v'", z.err)
-
-	if z.err != nil {
-		return z.err
+	if z.traceOn(Med) {
+		z.traceLogf(Med, "[close] err:'%v'", z.err)
 	}
 
 	defer z.task.End()
+	if !z.nested {
+		defer metricsAddStream(z.perf)
+	}
 
 	z.closed = true
+	z.releaseBuffers()
+	z.stopReadAhead()
+
+	if z.err != nil {
+		if z.q != nil {
+			z.q.Close()
+		}
+		return z.err
+	}
 
 	if z.q == nil {
 		z.err = ErrNone
 		return z.err
 	}
 
-	z.err = z.q.Close()
+	z.err = releaseSession(z.q)
 
 	return z.err
 }
 
+// Returns input and output buffers to the buffer pool
+func (z *Reader) releaseBuffers() {
+	putBuffer(z.inputBuf)
+	putBuffer(z.outputBuf)
+	z.inputBuf, z.outputBuf = nil, nil
+}
+
+// Stops the read-ahead goroutine and collects the prefetch time
+func (z *Reader) stopReadAhead() {
+	if z.ahead != nil {
+		z.perf.PrefetchTimeNS += z.ahead.close()
+		z.ahead = nil
+	}
+}
+
 // Reset discards current state, loads applied options, and restarts session
 func (z *Reader) Reset(r io.Reader) error {
 	z.err = z.Close()
@@ -77,12 +104,8 @@ func (z *Reader) Reset(r io.Reader) error {
 	}
 
 	z.ctx, z.task = trace.NewTask(context.Background(), "Qz io.Reader")
-	z.q, z.err = NewQzBinding()
-	if z.q == nil {
-		return z.err
-	}
-	z.q.setParams(z.p)
-	if z.err = z.q.StartSession(); z.err != nil {
+	z.q, z.err = acquireSession(z.p)
+	if z.err != nil {
 		return z.err
 	}
 
@@ -91,9 +114,12 @@ func (z *Reader) Reset(r io.Reader) error {
 	z.bufferGrowth = z.p.BufferGrowth
 
 	z.r = r
+	if z.p.ReadAheadDepth > 0 {
+		z.ahead = newReadPipeline(z.ctx, r, z.p.ReadAheadDepth, z.p.ReadAheadChunk)
+	}
 
-	z.inputBuf = make([]byte, z.p.InputBufLength)
-	z.outputBuf = make([]byte, z.p.OutputBufLength)
+	z.inputBuf = getBuffer(minInt(z.p.InputBufLength, z.p.MaxBufferLength))
+	z.outputBuf = getBuffer(minInt(z.p.OutputBufLength, z.p.MaxBufferLength))
 
 	z.inputBufOffset = 0
 	z.outputBufOffset = 0
@@ -102,11 +128,14 @@ func (z *Reader) Reset(r io.Reader) error {
 	z.closed = false
 
 	z.perf = new(Perf)
+	z.q.perf = z.perf
 
 	return nil
 }
 
 // Read() reads compressed data from io.Reader r and outputs decompressed data to p.
+// Input is consumed through a window of at most InputBufLength bytes and decompressed incrementally,
+// so memory use does not depend on the size of the compressed stream.
 func (z *Reader) Read(p []byte) (n int, err error) {
 	var t1, t2 int64 // for performance counters
 	if z.err != nil {
@@ -117,10 +146,12 @@ func (z *Reader) Read(p []byte) (n int, err error) {
 		if z.err = z.Reset(z.r); z.err != nil {
 			return 0, z.err
 		}
+	} else if z.closed {
+		return 0, ErrReaderClosed
 	}
 
-	r := trace.StartRegion(z.ctx, "Qz(1) Read()")
-	defer r.End()
+	r := startRegion(z.ctx, "Qz(1) Read()")
+	defer endRegion(r)
 
 	remainder := len(p) // bytes requested from input stream
 	produced := 0       // data copied into p[]
@@ -140,85 +171,292 @@ func (z *Reader) Read(p []byte) (n int, err error) {
 			continue
 		}
 
-		if z.inputBufRead-z.inputBufOffset < 0 {
-			z.err = fmt.Errorf(QatErrHdr+"internal assert: ibl:%v < ibofs:%v", z.inputBufRead, z.inputBufOffset)
+		// return what has been decompressed so far rather than block on input
+		if produced > 0 && z.needsInput() {
+			return produced, nil
+		}
+
+		// complete ZSTD frames in the input window are decoded straight into p
+		if np, err := z.decompressFrames(p[produced:]); err != nil {
+			return produced, err
+		} else if np > 0 {
+			produced += np
+			remainder -= np
+			continue
+		}
+
+		if err = z.advance(remainder); err != nil {
+			return produced, err
+		}
+	}
+
+	return produced, nil
+}
+
+// WriteTo decompresses the remaining stream and writes it to w directly from the QATzip output buffer
+func (z *Reader) WriteTo(w io.Writer) (n int64, err error) {
+	var t1, t2 int64 // for performance counters
+	if z.err != nil {
+		return 0, z.err
+	}
+
+	if z.q == nil {
+		if z.err = z.Reset(z.r); z.err != nil {
 			return 0, z.err
 		}
-		// fetch compressed data from input stream
-		if z.inputBufRead-z.inputBufOffset == 0 {
-			if z.streamDone {
-				return produced, io.EOF
+	} else if z.closed {
+		return 0, ErrReaderClosed
+	}
+
+	r := startRegion(z.ctx, "Qz(1) WriteTo()")
+	defer endRegion(r)
+
+	for {
+		if z.outputBufLeft > 0 {
+			rw := startRegion(z.ctx, "Qz(4) Output Stream")
+			t1 = time.Now().UnixNano()
+			nw, err := w.Write(z.outputBuf[z.outputBufOffset : z.outputBufOffset+z.outputBufLeft])
+			t2 = time.Now().UnixNano()
+			z.perf.WriteTimeNS += uint64(t2 - t1)
+			endRegion(rw)
+
+			z.outputBufOffset += nw
+			z.outputBufLeft -= nw
+			n += int64(nw)
+			if err == nil && z.outputBufLeft > 0 {
+				err = io.ErrShortWrite
 			}
+			if err != nil {
+				z.err = err
+				return n, err
+			}
+			continue
+		}
 
-			rr := trace.StartRegion(z.ctx, "Qz(3) Input Stream")
-			for !z.streamDone {
-				t1 = time.Now().UnixNano()
-				nt, err := z.r.Read(z.inputBuf[z.inputBufRead:])
-				t2 = time.Now().UnixNano()
-				z.perf.ReadTimeNS += uint64(t2 - t1)
-				z.inputBufRead += nt
-				z.traceLogf(Med, "[transfer] nt:%v iblen:%v ibr:%v err:%v", nt, len(z.inputBuf), z.inputBufRead, err)
-				if z.inputBufRead >= len(z.inputBuf) {
-					t1 = time.Now().UnixNano()
-					s := z.inputBufRead * 2
-					z.traceLogf(Med, "[expand input buffer] iblen:%v -> %v", len(z.inputBuf), s+len(z.inputBuf))
-					b := append(z.inputBuf, make([]byte, s)...)
-					t2 = time.Now().UnixNano()
-					z.perf.CopyTimeNS += uint64(t2 - t1)
-					z.inputBuf = b
-				}
-
-				if err != nil {
-					if err != io.EOF {
-						z.err = err
-						return 0, err
-					}
-					z.streamDone = true
-				}
+		if err = z.advance(len(z.outputBuf)); err != nil {
+			if err == io.EOF {
+				return n, nil
 			}
-			rr.End()
+			return n, err
 		}
+	}
+}
 
-		// decompress input data
-		rq := trace.StartRegion(z.ctx, "Qz(2) Decompress")
-		t1 = time.Now().UnixNano()
-		z.perf.BytesIn += uint64(z.inputBufRead - z.inputBufOffset)
-		in, out, err := z.q.Decompress(z.inputBuf[z.inputBufOffset:z.inputBufRead], z.outputBuf)
-		z.perf.BytesOut += uint64(out)
-		t2 = time.Now().UnixNano()
-		z.perf.EngineTimeNS += uint64(t2 - t1)
-		rq.End()
+// Reports whether decompression cannot continue without reading more input
+func (z *Reader) needsInput() bool {
+	return z.inputBufRead == z.inputBufOffset && !z.streamDone && !z.q.Pending()
+}
 
+// Performs one step of decompression once the output buffer is drained: reads more input or
+// decompresses from the input window into the output buffer. Returns io.EOF at the end of the stream.
+// remainder is the number of bytes wanted by the caller and sizes output buffer growth.
+func (z *Reader) advance(remainder int) (err error) {
+	var t1, t2 int64 // for performance counters
+
+	if z.inputBufRead-z.inputBufOffset < 0 {
+		z.err = fmt.Errorf(QatErrHdr+"internal assert: ibl:%v < ibofs:%v", z.inputBufRead, z.inputBufOffset)
+		return z.err
+	}
+
+	pending := z.inputBufRead - z.inputBufOffset
+	if pending == 0 && z.streamDone && !z.q.Pending() {
+		if z.perf.BytesIn == 0 {
+			z.err = ErrEmptyBuffer
+			return z.err
+		}
+		if z.p.Algorithm == ZSTD && z.q.inFrame() {
+			// the stream ends within a frame
+			z.err = ErrData
+			return z.err
+		}
+		return io.EOF
+	}
+
+	// fetch compressed data from input stream when the window is drained
+	if z.needsInput() {
+		if err = z.fill(); err != nil {
+			z.err = err
+		}
+		return err
+	}
+
+	if out, err := z.decompressFrames(z.outputBuf); err != nil || out > 0 {
+		z.outputBufOffset = 0
+		z.outputBufLeft = out
+		return err
+	}
+
+	// decompress input data
+	rq := startRegion(z.ctx, "Qz(2) Decompress")
+	t1 = time.Now().UnixNano()
+	z.q.SetLast(z.streamDone)
+	in, out, err := z.q.DecompressStream(z.inputBuf[z.inputBufOffset:z.inputBufRead], z.outputBuf)
+	z.perf.BytesIn += uint64(in)
+	z.perf.BytesOut += uint64(out)
+	t2 = time.Now().UnixNano()
+	z.perf.EngineTimeNS += uint64(t2 - t1)
+	endRegion(rq)
+
+	if z.traceOn(Med) {
 		z.traceLogf(Med, "[read->QAT] i:%v o:%v iblen:%v ibofs:%v ibr:%v obl:%v err:%v",
 			in, out, len(z.inputBuf), z.inputBufOffset, z.inputBufRead, len(z.outputBuf), err)
+	}
 
-		if err != nil {
-			if err == ErrBuffer {
-				// expand output buffer
-				// TODO grow to a maximum size
-				t1 = time.Now().UnixNano()
-				z.bufferGrowth *= 2
-				z.traceLogf(Med, "[expand output buffer] obl:%v -> %v", len(z.outputBuf), remainder+z.bufferGrowth)
-				z.outputBuf = make([]byte, remainder+z.bufferGrowth)
-				t2 = time.Now().UnixNano()
-				z.perf.CopyTimeNS += uint64(t2 - t1)
-				continue
+	if err != nil {
+		if err == ErrBuffer && len(z.outputBuf) < z.p.MaxBufferLength {
+			// expand output buffer up to MaxBufferLength
+			t1 = time.Now().UnixNano()
+			z.bufferGrowth *= 2
+			newSize := remainder + z.bufferGrowth
+			if newSize <= len(z.outputBuf) {
+				newSize = len(z.outputBuf) + z.bufferGrowth
 			}
+			if newSize > z.p.MaxBufferLength {
+				newSize = z.p.MaxBufferLength
+			}
+			if z.traceOn(Med) {
+				z.traceLogf(Med, "[expand output buffer] obl:%v -> %v", len(z.outputBuf), newSize)
+			}
+			putBuffer(z.outputBuf)
+			z.outputBuf = getBuffer(newSize)
+			t2 = time.Now().UnixNano()
+			z.perf.CopyTimeNS += uint64(t2 - t1)
+			return nil
+		}
+		z.err = err
+		return err
+	}
+
+	z.inputBufOffset += in
+	z.outputBufOffset = 0
+	z.outputBufLeft = out
+
+	if in == 0 && out == 0 {
+		if z.streamDone {
+			// no progress is possible on the remaining input
+			z.err = ErrData
+			return z.err
+		}
+		// the decompressor needs more input than the window currently holds
+		if err = z.fill(); err != nil {
 			z.err = err
-			return produced, err
 		}
+	}
 
-		z.inputBufOffset += in
-		z.outputBufOffset = 0
-		z.outputBufLeft = out
+	return err
+}
+
+// Decodes the complete ZSTD frames at the start of the input window into dst with a single call when their
+// content sizes are recorded and fit in dst. Returns 0 when the streaming decoder has to be used instead.
+func (z *Reader) decompressFrames(dst []byte) (n int, err error) {
+	if z.p.Algorithm != ZSTD || z.q.inFrame() || z.q.Pending() {
+		return 0, nil
 	}
 
-	return produced, nil
+	window := z.inputBuf[z.inputBufOffset:z.inputBufRead]
+	s := memberScanner{
+		alg: ZSTD,
+		ensure: func(n int) error {
+			if n > len(window) {
+				return io.ErrUnexpectedEOF
+			}
+			return nil
+		},
+		buf: func() []byte { return window },
+	}
+
+	size, usize := 0, 0
+	for size < len(window) {
+		fs, fu, err := s.next(size)
+		if err != nil || fu < 0 || usize+fu > len(dst) {
+			break
+		}
+		size += fs
+		usize += fu
+	}
+	if usize == 0 {
+		return 0, nil
+	}
+
+	rq := startRegion(z.ctx, "Qz(2) Decompress")
+	t1 := time.Now().UnixNano()
+	in, out, err := z.q.decompressFrames(window[:size], dst[:usize])
+	z.perf.BytesIn += uint64(in)
+	z.perf.BytesOut += uint64(out)
+	t2 := time.Now().UnixNano()
+	z.perf.EngineTimeNS += uint64(t2 - t1)
+	endRegion(rq)
+
+	if z.traceOn(Med) {
+		z.traceLogf(Med, "[read->QAT frames] i:%v o:%v ibofs:%v ibr:%v err:%v", in, out, z.inputBufOffset, z.inputBufRead, err)
+	}
+
+	if err == nil && out != usize {
+		err = ErrData
+	}
+	if err != nil {
+		z.err = err
+		return 0, err
+	}
+	z.inputBufOffset += in
+	return out, nil
+}
+
+// Reads the next piece of compressed input into the input window.
+// Unconsumed input is moved to the start of the window first, the window is never grown.
+func (z *Reader) fill() (err error) {
+	var t1, t2 int64 // for performance counters
+
+	if z.inputBufOffset > 0 {
+		t1 = time.Now().UnixNano()
+		z.inputBufRead = copy(z.inputBuf, z.inputBuf[z.inputBufOffset:z.inputBufRead])
+		z.inputBufOffset = 0
+		t2 = time.Now().UnixNano()
+		z.perf.CopyTimeNS += uint64(t2 - t1)
+	}
+
+	if z.inputBufRead >= len(z.inputBuf) {
+		// a single compressed unit does not fit within InputBufLength
+		return ErrBuffer
+	}
+
+	var in io.Reader = z.r
+	if z.ahead != nil {
+		in = z.ahead
+	}
+
+	rr := startRegion(z.ctx, "Qz(3) Input Stream")
+	t1 = time.Now().UnixNano()
+	nt, err := in.Read(z.inputBuf[z.inputBufRead:])
+	t2 = time.Now().UnixNano()
+	z.perf.ReadTimeNS += uint64(t2 - t1)
+	endRegion(rr)
+
+	z.inputBufRead += nt
+	if z.traceOn(Med) {
+		z.traceLogf(Med, "[transfer] nt:%v iblen:%v ibr:%v err:%v", nt, len(z.inputBuf), z.inputBufRead, err)
+	}
+
+	if err != nil {
+		if err != io.EOF {
+			return err
+		}
+		z.streamDone = true
+	}
+
+	return nil
 }
 
 // Get performance counters from Reader
 func (z *Reader) GetPerf() Perf {
-	return *z.perf
+	if z.q != nil && !z.closed {
+		z.q.collectStats()
+	}
+	p := *z.perf
+	if z.ahead != nil {
+		p.PrefetchTimeNS += z.ahead.prefetchTime()
+	}
+	return p
 }
 
 // Apply options to Reader
@@ -0,0 +1,114 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+package qatzip
+
+/*
+#include "qatzip_internal.h"
+*/
+import "C"
+
+import (
+	"runtime"
+	"sync"
+	"sync/atomic"
+	"unsafe"
+)
+
+// ZstdDictionary is a ZSTD dictionary prepared once and shared by every session that uses it.
+// Compression dictionaries (ZSTD_CDict) are prepared per compression level on first use,
+// the decompression dictionary (ZSTD_DDict) when the first Reader needs it.
+// Prepared dictionaries are freed once the ZstdDictionary and all sessions using it are unreachable.
+type ZstdDictionary struct {
+	id     uint64 // identifies the dictionary in the session pool without keeping it reachable
+	dict   []byte
+	mu     sync.Mutex
+	cdicts map[int]unsafe.Pointer // by compression level
+	ddict  unsafe.Pointer
+}
+
+var dictionaryIDs uint64
+
+// NewZstdDictionary creates a dictionary from dict, which may be a trained dictionary or raw content
+func NewZstdDictionary(dict []byte) (*ZstdDictionary, error) {
+	if len(dict) == 0 {
+		return nil, ErrEmptyBuffer
+	}
+
+	d := &ZstdDictionary{
+		id:     atomic.AddUint64(&dictionaryIDs, 1),
+		dict:   append([]byte(nil), dict...),
+		cdicts: make(map[int]unsafe.Pointer),
+	}
+	runtime.SetFinalizer(d, (*ZstdDictionary).free)
+	return d, nil
+}
+
+// Returns the ZSTD_CDict for compression level level
+func (d *ZstdDictionary) cdict(level int) (unsafe.Pointer, error) {
+	d.mu.Lock()
+	defer d.mu.Unlock()
+
+	if c, ok := d.cdicts[level]; ok {
+		return c, nil
+	}
+	c := C.qatzip_zstd_create_cdict(unsafe.Pointer(&d.dict[0]), C.size_t(len(d.dict)), C.int(level))
+	if c == nil {
+		return nil, ErrNoSwAvail
+	}
+	d.cdicts[level] = c
+	return c, nil
+}
+
+// Returns the ZSTD_DDict
+func (d *ZstdDictionary) prepareDDict() (unsafe.Pointer, error) {
+	d.mu.Lock()
+	defer d.mu.Unlock()
+
+	if d.ddict == nil {
+		d.ddict = C.qatzip_zstd_create_ddict(unsafe.Pointer(&d.dict[0]), C.size_t(len(d.dict)))
+		if d.ddict == nil {
+			return nil, ErrNoSwAvail
+		}
+	}
+	return d.ddict, nil
+}
+
+func (d *ZstdDictionary) free() {
+	forgetPrewarmed(d.id)
+	for _, c := range d.cdicts {
+		C.qatzip_zstd_free_dicts(c, nil)
+	}
+	C.qatzip_zstd_free_dicts(nil, d.ddict)
+}
+
+// TrainZstdDictionary trains a dictionary of at most size bytes from samples of typical payloads
+func TrainZstdDictionary(samples [][]byte, size int) ([]byte, error) {
+	if len(samples) == 0 || size <= 0 {
+		return nil, ErrParams
+	}
+
+	total := 0
+	for _, s := range samples {
+		total += len(s)
+	}
+	if total == 0 {
+		return nil, ErrEmptyBuffer
+	}
+
+	packed := make([]byte, 0, total)
+	sizes := make([]C.size_t, len(samples))
+	for i, s := range samples {
+		packed = append(packed, s...)
+		sizes[i] = C.size_t(len(s))
+	}
+
+	dict := make([]byte, size)
+	dictSize := C.size_t(size)
+	status := int(C.qatzip_zstd_train_dict(unsafe.Pointer(&dict[0]), &dictSize,
+		unsafe.Pointer(&packed[0]), &sizes[0], C.uint(len(samples))))
+	if err := Error(status); err != nil {
+		return nil, err
+	}
+
+	return dict[:dictSize], nil
+}
@@ -32,7 +32,21 @@ var (
 	ErrParamOutputBufLength    = errors.New(QatErrHdr + "invalid size for output buffer length")
 	ErrParamInputBufLength     = errors.New(QatErrHdr + "invalid size for input buffer length")
 	ErrParamBufferGrowth       = errors.New(QatErrHdr + "invalid size for buffer Growth")
+	ErrParamMaxBufferLength    = errors.New(QatErrHdr + "invalid size for maximum buffer length")
 	ErrParamBounceBufferLength = errors.New(QatErrHdr + "invalid size for bounce buffer length")
+	ErrParamPipelineDepth      = errors.New(QatErrHdr + "invalid pipeline depth")
+	ErrParamReadAhead          = errors.New(QatErrHdr + "invalid read-ahead depth or chunk length")
+	ErrParamBlockSize          = errors.New(QatErrHdr + "invalid block size")
+	ErrParamWorkers            = errors.New(QatErrHdr + "invalid number of workers")
+	ErrParamParallelFmt        = errors.New(QatErrHdr + "data format cannot be compressed in parallel")
+	ErrParamPollers            = errors.New(QatErrHdr + "invalid number of pollers")
+	ErrParamSeekable           = errors.New(QatErrHdr + "block size too large for a seek table")
+	ErrParamChecksum           = errors.New(QatErrHdr + "invalid checksum kind")
+	ErrParamHybridDepth        = errors.New(QatErrHdr + "invalid hybrid compressor depth")
+	ErrParamZstdDictionary     = errors.New(QatErrHdr + "dictionaries are only supported with zstd")
+	ErrParamZstd               = errors.New(QatErrHdr + "invalid zstd parameter")
+	ErrParamDevice             = errors.New(QatErrHdr + "no such QAT device")
+	ErrAsyncClosed             = errors.New(QatErrHdr + "cannot submit to closed async compressor")
 	ErrParamAlgorithm          = errors.New(QatErrHdr + "invalid algorithm type")
 	ErrParamDirection          = errors.New(QatErrHdr + "invalid direction")
 	ErrParamDataFmtDeflate     = errors.New(QatErrHdr + "invalid deflate format type")
@@ -40,11 +54,15 @@ var (
 	ErrParamPollingMode        = errors.New(QatErrHdr + "invalid polling mode")
 	ErrParamCompressionLevel   = errors.New(QatErrHdr + "invalid compression level")
 	ErrWriterClosed            = errors.New(QatErrHdr + "cannot write to closed writer")
+	ErrReaderClosed            = errors.New(QatErrHdr + "cannot read from closed reader")
 	ErrEmptyBuffer             = errors.New(QatErrHdr + "empty buffer")
 	ErrNoMem                   = errors.New(QatErrHdr + "out of memory")
 	ErrInputBufferMode         = errors.New(QatErrHdr + "invalid input buffer mode")
 	ErrApplyPostInit           = errors.New(QatErrHdr + "cannot apply options after Reset() or I/O")
 	ErrApplyInvalidType        = errors.New(QatErrHdr + "option appied to incorrect type")
+	ErrSeekTable               = errors.New(QatErrHdr + "missing or corrupt seek table")
+	ErrNotPinned               = errors.New(QatErrHdr + "buffer was not allocated by AllocBuffer")
+	ErrSeekOffset              = errors.New(QatErrHdr + "invalid seek offset")
 )
 
 func Error(errorCode int) (err error) {
@@ -0,0 +1,154 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+package qatzip
+
+import (
+	"bytes"
+	"io"
+	"os"
+	"syscall"
+)
+
+// Largest part of a mapped file passed to one Write, QATzip buffer lengths are 32 bit
+const mappedChunk = 1 << 30
+
+// CompressFile compresses the file src into the file dst, which is created or truncated.
+// See CompressFileTo.
+func CompressFile(src string, dst string, options ...Option) (perf Perf, err error) {
+	return fileOp(src, dst, options, CompressFileTo)
+}
+
+// DecompressFile decompresses the file src into the file dst, which is created or truncated.
+// See DecompressFileTo.
+func DecompressFile(src string, dst string, options ...Option) (perf Perf, err error) {
+	return fileOp(src, dst, options, DecompressFileTo)
+}
+
+func fileOp(src string, dst string, options []Option, op func(io.Writer, *os.File, ...Option) (Perf, error)) (perf Perf, err error) {
+	fin, err := os.Open(src)
+	if err != nil {
+		return perf, err
+	}
+	defer fin.Close()
+
+	fout, err := os.Create(dst)
+	if err != nil {
+		return perf, err
+	}
+
+	perf, err = op(fout, fin, options...)
+	if cerr := fout.Close(); err == nil {
+		err = cerr
+	}
+	return perf, err
+}
+
+// CompressFileTo compresses f into w and returns the performance counters of the stream.
+// Options are applied as for Writer and ParallelWriter: with more than one worker (WorkersOption,
+// default 4) the input is split into blocks compressed concurrently, otherwise it is compressed as
+// one stream. Regular files are memory-mapped and compressed in place without read(2) into Go
+// buffers, other files are streamed. A mapped file must not be truncated during compression.
+func CompressFileTo(w io.Writer, f *os.File, options ...Option) (perf Perf, err error) {
+	sz := NewWriter(w)
+	pz := NewParallelWriter(w)
+	if err = applyFileOptions(sz, pz, options); err != nil {
+		return perf, err
+	}
+
+	mapped := mapFile(f)
+	if mapped != nil {
+		defer syscall.Munmap(mapped)
+	}
+
+	if pz.p.Workers > 1 {
+		if mapped != nil {
+			err = pz.writeInPlace(mapped)
+		} else {
+			_, err = io.CopyBuffer(pz, f, make([]byte, pz.p.BlockSize))
+		}
+		if cerr := pz.Close(); err == nil {
+			err = cerr
+		}
+		return pz.GetPerf(), err
+	}
+
+	if mapped != nil {
+		for off := 0; off < len(mapped) && err == nil; off += mappedChunk {
+			_, err = sz.Write(mapped[off:minInt(off+mappedChunk, len(mapped))])
+		}
+	} else {
+		_, err = sz.ReadFrom(f)
+	}
+	if cerr := sz.Close(); err == nil {
+		err = cerr
+	}
+	return sz.GetPerf(), err
+}
+
+// DecompressFileTo decompresses f into w and returns the performance counters of the stream.
+// Options are applied as for Reader and ParallelReader: with more than one worker (WorkersOption,
+// default 4) members are decompressed concurrently. Regular files are memory-mapped instead of read.
+func DecompressFileTo(w io.Writer, f *os.File, options ...Option) (perf Perf, err error) {
+	sz, _ := NewReader(nil)
+	pz, _ := NewParallelReader(nil)
+	if err = applyFileOptions(sz, pz, options); err != nil {
+		return perf, err
+	}
+
+	var r io.Reader = f
+	if mapped := mapFile(f); mapped != nil {
+		defer syscall.Munmap(mapped)
+		r = bytes.NewReader(mapped)
+	}
+
+	var z interface {
+		io.WriterTo
+		io.Closer
+		GetPerf() Perf
+	}
+	if pz.p.Workers > 1 {
+		pz.r = r
+		z = pz
+	} else {
+		sz.r = r
+		z = sz
+	}
+
+	_, err = z.WriteTo(w)
+	if cerr := z.Close(); err == nil {
+		err = cerr
+	}
+	return z.GetPerf(), err
+}
+
+// Applies each option to the serial and the parallel stream, an option must suit at least one of them
+func applyFileOptions(serial applier, parallel applier, options []Option) error {
+	for _, op := range options {
+		serr := serial.Apply(op)
+		perr := parallel.Apply(op)
+		if serr == ErrApplyInvalidType {
+			serr = perr
+		} else if perr != ErrApplyInvalidType && serr == nil {
+			serr = perr
+		}
+		if serr != nil {
+			return serr
+		}
+	}
+	return nil
+}
+
+// Maps a regular file read-only for sequential access, returns nil if the file is empty or cannot be mapped
+func mapFile(f *os.File) []byte {
+	fi, err := f.Stat()
+	if err != nil || !fi.Mode().IsRegular() || fi.Size() == 0 || int64(int(fi.Size())) != fi.Size() {
+		return nil
+	}
+
+	b, err := syscall.Mmap(int(f.Fd()), 0, int(fi.Size()), syscall.PROT_READ, syscall.MAP_SHARED)
+	if err != nil {
+		return nil
+	}
+	syscall.Madvise(b, syscall.MADV_SEQUENTIAL)
+	return b
+}
@@ -0,0 +1,309 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+package qatzip
+
+import (
+	"bytes"
+	"compress/flate"
+	"compress/gzip"
+	"io"
+	"math/bits"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"github.com/DataDog/zstd"
+	"github.com/pierrec/lz4/v4"
+)
+
+const (
+	hybridClasses = 32 // request size classes, powers of two
+	hybridWarmup  = 4  // samples taken on each path before predictions are used
+	hybridExplore = 32 // every n-th request of a class refreshes the estimate of the slower path
+	hybridEWMA    = 8  // weight of a new sample is 1/hybridEWMA
+)
+
+// HybridCompressor compresses complete buffers (as CompressBlock) either on QAT or with an in-process
+// software encoder, whichever is predicted to finish first. Predictions use the measured latency per
+// byte of each path by request size and the number of requests currently in flight on the device:
+// once more than depth requests are in flight, QAT requests are expected to queue.
+// Software output uses the same format (gzip members with the QZ extra field, gzip, raw DEFLATE, LZ4 frame,
+// ZSTD frame) and is decompressed by Reader, ParallelReader and DecompressBlock. Formats without a software encoder (DEFLATE 4B/48, ZSTD dictionaries
+// and advanced ZSTD parameters) always use QAT.
+type HybridCompressor struct {
+	p        params
+	depth    int   // requests the device serves concurrently
+	inFlight int64 // QAT requests in flight
+	software bool  // a software encoder exists for the configured format
+	mu       sync.Mutex
+	classes  [hybridClasses]hybridClass
+	stats    HybridStats
+}
+
+// HybridStats counts the requests routed by a HybridCompressor
+type HybridStats struct {
+	HwRequests uint64 // requests compressed on QAT
+	SwRequests uint64 // requests compressed in software
+}
+
+type hybridClass struct {
+	hw, sw   hybridEstimate
+	requests uint64
+}
+
+// Exponentially weighted latency per byte of one path
+type hybridEstimate struct {
+	nsPerByte float64
+	samples   uint64
+}
+
+func (e *hybridEstimate) add(ns float64) {
+	if e.samples == 0 {
+		e.nsPerByte = ns
+	} else {
+		e.nsPerByte += (ns - e.nsPerByte) / hybridEWMA
+	}
+	e.samples++
+}
+
+// NewHybridCompressor creates a HybridCompressor for a device serving depth concurrent requests.
+// Options are applied as for AcquireQzBinding.
+func NewHybridCompressor(depth int, options ...Option) (*HybridCompressor, error) {
+	if depth <= 0 {
+		return nil, ErrParamHybridDepth
+	}
+
+	p, err := bindingParams(options...)
+	if err != nil {
+		return nil, err
+	}
+
+	return &HybridCompressor{p: p, depth: depth, software: softwareSupported(p)}, nil
+}
+
+// Compress compresses src into a complete member/frame, using dst as CompressBlock does
+func (h *HybridCompressor) Compress(dst []byte, src []byte) ([]byte, error) {
+	if len(src) == 0 {
+		buf, err := emptyStream(h.p)
+		if err != nil {
+			return nil, err
+		}
+		return append(dst[:0], buf...), nil
+	}
+
+	class := minInt(bits.Len(uint(len(src))), hybridClasses-1)
+	hw := h.route(class, len(src))
+
+	t1 := time.Now().UnixNano()
+	var out []byte
+	var err error
+	fallback := false
+	if hw {
+		atomic.AddInt64(&h.inFlight, 1)
+		out, err = h.compressHw(dst, src)
+		atomic.AddInt64(&h.inFlight, -1)
+		if err != nil && h.software {
+			// the device is not usable, the cost of the attempt is charged to the QAT path
+			fallback = true
+			out, err = softwareCompress(h.p, dst, src)
+		}
+	} else {
+		out, err = softwareCompress(h.p, dst, src)
+	}
+	t2 := time.Now().UnixNano()
+	if err != nil {
+		return nil, err
+	}
+
+	h.mu.Lock()
+	ns := float64(t2-t1) / float64(len(src))
+	if hw {
+		h.classes[class].hw.add(ns)
+	} else {
+		h.classes[class].sw.add(ns)
+	}
+	if hw && !fallback {
+		h.stats.HwRequests++
+	} else {
+		h.stats.SwRequests++
+	}
+	h.mu.Unlock()
+
+	return out, nil
+}
+
+// Stats returns the number of requests routed to each path so far
+func (h *HybridCompressor) Stats() HybridStats {
+	h.mu.Lock()
+	defer h.mu.Unlock()
+	return h.stats
+}
+
+// Reports whether a request of n bytes in size class class is sent to QAT
+func (h *HybridCompressor) route(class int, n int) bool {
+	if !h.software {
+		return true
+	}
+
+	h.mu.Lock()
+	defer h.mu.Unlock()
+
+	c := &h.classes[class]
+	c.requests++
+	switch {
+	case c.hw.samples < hybridWarmup:
+		return true
+	case c.sw.samples < hybridWarmup:
+		return false
+	}
+
+	hw := hybridPredict(c.hw.nsPerByte, n, atomic.LoadInt64(&h.inFlight), h.depth) <= c.sw.nsPerByte*float64(n)
+	if c.requests%hybridExplore == 0 {
+		return !hw
+	}
+	return hw
+}
+
+// Predicted QAT latency of n bytes with inFlight requests already on a device serving depth concurrently
+func hybridPredict(nsPerByte float64, n int, inFlight int64, depth int) float64 {
+	ns := nsPerByte * float64(n)
+	if queued := inFlight + 1 - int64(depth); queued > 0 {
+		ns *= 1 + float64(queued)/float64(depth)
+	}
+	return ns
+}
+
+func (h *HybridCompressor) compressHw(dst []byte, src []byte) ([]byte, error) {
+	q, err := acquireSession(h.p)
+	if err != nil {
+		return nil, err
+	}
+	out, err := compressInto(q, dst, src)
+	if err != nil {
+		q.Close()
+		return nil, err
+	}
+	return out, releaseSession(q)
+}
+
+// Reports whether softwareCompress produces the format configured by p
+func softwareSupported(p params) bool {
+	switch p.Algorithm {
+	case DEFLATE:
+		return p.DataFmtDeflate == DeflateGzip || p.DataFmtDeflate == DeflateGzipExt || p.DataFmtDeflate == DeflateRaw
+	case LZ4:
+		return true
+	case ZSTD:
+		return p.ZstdDictionary == nil && p.ZstdWorkers == 0 && p.ZstdLongDistance == 0 && p.ZstdWindowLog == 0 && p.ZstdChecksum == 0
+	}
+	return false
+}
+
+// Pooled software encoders by level
+var (
+	gzipWriters  [flate.BestCompression + 1]sync.Pool
+	flateWriters [flate.BestCompression + 1]sync.Pool
+	lz4Writers   [10]sync.Pool
+)
+
+var lz4Levels = [10]lz4.CompressionLevel{lz4.Fast, lz4.Level1, lz4.Level2, lz4.Level3, lz4.Level4, lz4.Level5,
+	lz4.Level6, lz4.Level7, lz4.Level8, lz4.Level9}
+
+// Compresses src into a complete gzip member, raw DEFLATE stream, LZ4 frame or ZSTD frame in software
+func softwareCompress(p params, dst []byte, src []byte) ([]byte, error) {
+	if p.Algorithm == ZSTD {
+		return zstd.CompressLevel(dst[:cap(dst)], src, p.Level)
+	}
+
+	buf := bytes.NewBuffer(dst[:0])
+	level := p.Level
+	if level < flate.BestSpeed {
+		level = flate.BestSpeed
+	} else if level > flate.BestCompression {
+		level = flate.BestCompression
+	}
+
+	switch {
+	case p.Algorithm == LZ4:
+		l := minInt(p.Level, len(lz4Levels)-1)
+		w, ok := lz4Writers[l].Get().(*lz4.Writer)
+		if !ok {
+			w = lz4.NewWriter(buf)
+			if err := w.Apply(lz4.CompressionLevelOption(lz4Levels[l])); err != nil {
+				return nil, err
+			}
+		} else {
+			w.Reset(buf)
+		}
+		_, err := w.Write(src)
+		if err == nil {
+			err = w.Close()
+		}
+		w.Reset(io.Discard)
+		lz4Writers[l].Put(w)
+		if err != nil {
+			return nil, err
+		}
+	case p.DataFmtDeflate == DeflateRaw:
+		if err := softwareDeflate(buf, level, src); err != nil {
+			return nil, err
+		}
+	case p.DataFmtDeflate == DeflateGzipExt:
+		// one member with the QZ extra field per hardware buffer, as QATzip writes them
+		hw := p.hwBufSize()
+		out := dst[:0]
+		deflated := new(bytes.Buffer)
+		for off := 0; off < len(src); off += hw {
+			chunk := src[off:minInt(off+hw, len(src))]
+			deflated.Reset()
+			if err := softwareDeflate(deflated, level, chunk); err != nil {
+				return nil, err
+			}
+			out = appendGzipHeader(out, true, len(chunk), deflated.Len())
+			out = append(out, deflated.Bytes()...)
+			out = appendGzipTrailer(out, chunk)
+		}
+		return out, nil
+	default:
+		w, ok := gzipWriters[level].Get().(*gzip.Writer)
+		if !ok {
+			var err error
+			if w, err = gzip.NewWriterLevel(buf, level); err != nil {
+				return nil, err
+			}
+		} else {
+			w.Reset(buf)
+		}
+		_, err := w.Write(src)
+		if err == nil {
+			err = w.Close()
+		}
+		w.Reset(io.Discard)
+		gzipWriters[level].Put(w)
+		if err != nil {
+			return nil, err
+		}
+	}
+
+	return buf.Bytes(), nil
+}
+
+// Compresses src as a raw DEFLATE stream into buf with a pooled encoder
+func softwareDeflate(buf *bytes.Buffer, level int, src []byte) error {
+	w, ok := flateWriters[level].Get().(*flate.Writer)
+	if !ok {
+		var err error
+		if w, err = flate.NewWriter(buf, level); err != nil {
+			return err
+		}
+	} else {
+		w.Reset(buf)
+	}
+	_, err := w.Write(src)
+	if err == nil {
+		err = w.Close()
+	}
+	w.Reset(io.Discard)
+	flateWriters[level].Put(w)
+	return err
+}
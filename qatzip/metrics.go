@@ -0,0 +1,231 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+package qatzip
+
+import (
+	"expvar"
+	"math/bits"
+	"sync/atomic"
+	"time"
+)
+
+const (
+	// log-linear histogram: 2^histSubBits buckets per power of two (12.5% resolution)
+	histSubBits    = 3
+	histSubBuckets = 1 << histSubBits
+	histBuckets    = (65 - histSubBits) * histSubBuckets
+)
+
+// LatencyHistogram is a lock-free HDR-style histogram of latencies in nanoseconds
+type LatencyHistogram struct {
+	counts [histBuckets]uint64
+	count  uint64
+	sum    uint64
+	max    uint64
+}
+
+// LatencySnapshot summarizes a LatencyHistogram, quantiles are accurate to 12.5%
+type LatencySnapshot struct {
+	Count uint64
+	Mean  time.Duration
+	P50   time.Duration
+	P99   time.Duration
+	P999  time.Duration
+	Max   time.Duration
+}
+
+func histBucket(ns uint64) int {
+	if ns < 2*histSubBuckets {
+		return int(ns)
+	}
+	shift := bits.Len64(ns) - histSubBits - 1
+	return shift*histSubBuckets + int(ns>>shift)
+}
+
+// Largest value that falls in bucket i
+func histUpper(i int) uint64 {
+	if i < 2*histSubBuckets {
+		return uint64(i)
+	}
+	shift := i/histSubBuckets - 1
+	return uint64(i%histSubBuckets+histSubBuckets)<<shift + 1<<shift - 1
+}
+
+// Record adds one latency
+func (h *LatencyHistogram) Record(d time.Duration) {
+	ns := uint64(d)
+	if d < 0 {
+		ns = 0
+	}
+	atomic.AddUint64(&h.counts[histBucket(ns)], 1)
+	atomic.AddUint64(&h.count, 1)
+	atomic.AddUint64(&h.sum, ns)
+	for {
+		m := atomic.LoadUint64(&h.max)
+		if ns <= m || atomic.CompareAndSwapUint64(&h.max, m, ns) {
+			return
+		}
+	}
+}
+
+// Snapshot returns the count, mean, p50, p99, p999 and maximum recorded so far
+func (h *LatencyHistogram) Snapshot() (s LatencySnapshot) {
+	var counts [histBuckets]uint64
+	var total uint64
+	for i := range counts {
+		counts[i] = atomic.LoadUint64(&h.counts[i])
+		total += counts[i]
+	}
+
+	s.Count = total
+	s.Max = time.Duration(atomic.LoadUint64(&h.max))
+	if n := atomic.LoadUint64(&h.count); n > 0 {
+		s.Mean = time.Duration(atomic.LoadUint64(&h.sum) / n)
+	}
+
+	quantile := func(q float64) time.Duration {
+		rank := uint64(q*float64(total) + 0.5)
+		if rank == 0 {
+			rank = 1
+		}
+		var seen uint64
+		for i, c := range counts {
+			seen += c
+			if seen >= rank {
+				if v := time.Duration(histUpper(i)); v < s.Max {
+					return v
+				}
+				return s.Max
+			}
+		}
+		return s.Max
+	}
+	if total > 0 {
+		s.P50 = quantile(0.50)
+		s.P99 = quantile(0.99)
+		s.P999 = quantile(0.999)
+	}
+	return s
+}
+
+// Reset clears the histogram
+func (h *LatencyHistogram) Reset() {
+	for i := range h.counts {
+		atomic.StoreUint64(&h.counts[i], 0)
+	}
+	atomic.StoreUint64(&h.count, 0)
+	atomic.StoreUint64(&h.sum, 0)
+	atomic.StoreUint64(&h.max, 0)
+}
+
+// Process-wide metrics, disabled until SetMetricsSampling is called
+var metrics struct {
+	sampling    uint64 // record every n-th call, 0 disables latency recording
+	calls       uint64
+	compress    LatencyHistogram // QzBinding.Compress and CompressCRC
+	decompress  LatencyHistogram // QzBinding.Decompress and DecompressStream
+	totals      Perf             // Perf of every closed stream
+	totalStream uint64
+}
+
+// SetMetricsSampling records the latency of every n-th QATzip compress and decompress call
+// in process-wide histograms (see GetMetrics). 0 disables recording (default).
+func SetMetricsSampling(n int) error {
+	if n < 0 {
+		return ErrParams
+	}
+	atomic.StoreUint64(&metrics.sampling, uint64(n))
+	return nil
+}
+
+// Returns the start time of a sampled call or 0 when the call is not sampled
+func metricsStart() int64 {
+	n := atomic.LoadUint64(&metrics.sampling)
+	if n == 0 || (n > 1 && atomic.AddUint64(&metrics.calls, 1)%n != 0) {
+		return 0
+	}
+	return time.Now().UnixNano()
+}
+
+// Records the latency of a call sampled by metricsStart
+func metricsEnd(h *LatencyHistogram, start int64) {
+	if start != 0 {
+		h.Record(time.Duration(time.Now().UnixNano() - start))
+	}
+}
+
+// Adds the counters of a closed stream to the process-wide totals
+func metricsAddStream(p *Perf) {
+	if p == nil {
+		return
+	}
+	metrics.totals.add(p)
+	atomic.AddUint64(&metrics.totalStream, 1)
+}
+
+// Adds o to p, safe for concurrent use
+func (p *Perf) add(o *Perf) {
+	atomic.AddUint64(&p.ReadTimeNS, o.ReadTimeNS)
+	atomic.AddUint64(&p.PrefetchTimeNS, o.PrefetchTimeNS)
+	atomic.AddUint64(&p.WriteTimeNS, o.WriteTimeNS)
+	atomic.AddUint64(&p.BytesIn, o.BytesIn)
+	atomic.AddUint64(&p.BytesOut, o.BytesOut)
+	atomic.AddUint64(&p.BytesStored, o.BytesStored)
+	atomic.AddUint64(&p.EngineTimeNS, o.EngineTimeNS)
+	atomic.AddUint64(&p.CopyTimeNS, o.CopyTimeNS)
+	p.ExecStats.add(o.ExecStats)
+}
+
+// Returns a copy of p that is safe against concurrent add
+func (p *Perf) load() Perf {
+	return Perf{
+		ReadTimeNS:     atomic.LoadUint64(&p.ReadTimeNS),
+		PrefetchTimeNS: atomic.LoadUint64(&p.PrefetchTimeNS),
+		WriteTimeNS:    atomic.LoadUint64(&p.WriteTimeNS),
+		BytesIn:        atomic.LoadUint64(&p.BytesIn),
+		BytesOut:       atomic.LoadUint64(&p.BytesOut),
+		BytesStored:    atomic.LoadUint64(&p.BytesStored),
+		EngineTimeNS:   atomic.LoadUint64(&p.EngineTimeNS),
+		CopyTimeNS:     atomic.LoadUint64(&p.CopyTimeNS),
+		ExecStats: ExecStats{
+			HwRequests:        atomic.LoadUint64(&p.HwRequests),
+			SwRequests:        atomic.LoadUint64(&p.SwRequests),
+			SwSmallRequests:   atomic.LoadUint64(&p.SwSmallRequests),
+			SwBackoffRequests: atomic.LoadUint64(&p.SwBackoffRequests),
+			HwFallbacks:       atomic.LoadUint64(&p.HwFallbacks),
+			HwRetries:         atomic.LoadUint64(&p.HwRetries),
+		},
+	}
+}
+
+// Metrics is a snapshot of the process-wide metrics
+type Metrics struct {
+	Compress   LatencySnapshot // latency of QATzip compress calls
+	Decompress LatencySnapshot // latency of QATzip decompress calls
+	Streams    uint64          // closed Writers, Readers, ParallelWriters and ParallelReaders
+	Totals     Perf            // sum of the Perf of the closed streams
+	Exec       ExecStats       // requests executed in hardware and software (GetExecStats)
+}
+
+// GetMetrics returns the process-wide metrics
+func GetMetrics() Metrics {
+	return Metrics{
+		Compress:   metrics.compress.Snapshot(),
+		Decompress: metrics.decompress.Snapshot(),
+		Streams:    atomic.LoadUint64(&metrics.totalStream),
+		Totals:     metrics.totals.load(),
+		Exec:       GetExecStats(),
+	}
+}
+
+// ResetMetrics clears the latency histograms
+func ResetMetrics() {
+	metrics.compress.Reset()
+	metrics.decompress.Reset()
+}
+
+// PublishMetrics exports GetMetrics as the expvar variable name (for example on /debug/vars).
+// Other metrics systems can poll GetMetrics instead.
+func PublishMetrics(name string) {
+	expvar.Publish(name, expvar.Func(func() any { return GetMetrics() }))
+}
@@ -23,6 +23,8 @@ func CompressionLevelOption(level int) Option {
 		switch z := a.(type) {
 		case *Writer:
 			z.p.Level = level
+		case *ParallelWriter:
+			z.p.Level = level
 		case *QzBinding:
 			z.p.Level = level
 		default:
@@ -43,8 +45,12 @@ func AlgorithmOption(alg Algorithm) Option {
 		switch z := a.(type) {
 		case *Reader:
 			z.p.Algorithm = alg
+		case *ParallelReader:
+			z.p.Algorithm = alg
 		case *Writer:
 			z.p.Algorithm = alg
+		case *ParallelWriter:
+			z.p.Algorithm = alg
 		case *QzBinding:
 			z.p.Algorithm = alg
 		default:
@@ -65,8 +71,12 @@ func PollingModeOption(mode PollingMode) Option {
 		switch z := a.(type) {
 		case *Reader:
 			z.p.PollingMode = mode
+		case *ParallelReader:
+			z.p.PollingMode = mode
 		case *Writer:
 			z.p.PollingMode = mode
+		case *ParallelWriter:
+			z.p.PollingMode = mode
 		case *QzBinding:
 			z.p.PollingMode = mode
 		default:
@@ -87,8 +97,12 @@ func DeflateFmtOption(fmt DeflateFmt) Option {
 		switch z := a.(type) {
 		case *Reader:
 			z.p.DataFmtDeflate = fmt
+		case *ParallelReader:
+			z.p.DataFmtDeflate = fmt
 		case *Writer:
 			z.p.DataFmtDeflate = fmt
+		case *ParallelWriter:
+			z.p.DataFmtDeflate = fmt
 		case *QzBinding:
 			z.p.DataFmtDeflate = fmt
 		default:
@@ -109,6 +123,8 @@ func HuffmanHdrOption(hdrType HuffmanHdr) Option {
 		switch z := a.(type) {
 		case *Writer:
 			z.p.HuffmanHdr = hdrType
+		case *ParallelWriter:
+			z.p.HuffmanHdr = hdrType
 		case *QzBinding:
 			z.p.HuffmanHdr = hdrType
 		default:
@@ -137,6 +153,16 @@ func DirOption(dir Direction) Option {
 				return ErrParams
 			}
 			z.p.Direction = dir
+		case *ParallelReader:
+			if dir == Compress {
+				return ErrParams
+			}
+			z.p.Direction = dir
+		case *ParallelWriter:
+			if dir == Decompress {
+				return ErrParams
+			}
+			z.p.Direction = dir
 		case *QzBinding:
 			z.p.Direction = dir
 		default:
@@ -147,7 +173,7 @@ func DirOption(dir Direction) Option {
 	}
 }
 
-// Input buffer mode setting (Writer) [Reserve, Bounce, Last, NoLast]
+// Input buffer mode setting (Writer) [Reserve, Bounce, Last, NoLast, DeferLast]
 func InputBufferModeOption(mode InputBufferMode) Option {
 	return func(a applier) error {
 		if !mode.isValid() {
@@ -171,8 +197,12 @@ func DebugLevelOption(level DebugLevel) Option {
 		switch z := a.(type) {
 		case *Reader:
 			z.p.DebugLevel = level
+		case *ParallelReader:
+			z.p.DebugLevel = level
 		case *Writer:
 			z.p.DebugLevel = level
+		case *ParallelWriter:
+			z.p.DebugLevel = level
 		case *QzBinding:
 			z.p.DebugLevel = level
 		default:
@@ -183,7 +213,7 @@ func DebugLevelOption(level DebugLevel) Option {
 	}
 }
 
-// Output buffer size (Reader, Writer)
+// Output buffer size (Reader, Writer, serial fallback of ParallelReader)
 func OutputBufLengthOption(len int) Option {
 	return func(a applier) error {
 		if len < MinBufferLength {
@@ -195,6 +225,8 @@ func OutputBufLengthOption(len int) Option {
 			z.p.OutputBufLength = len
 		case *Reader:
 			z.p.OutputBufLength = len
+		case *ParallelReader:
+			z.p.OutputBufLength = len
 		default:
 			return ErrApplyInvalidType
 		}
@@ -203,7 +235,7 @@ func OutputBufLengthOption(len int) Option {
 	}
 }
 
-// Input buffer length (Reader)
+// Input buffer length (Reader, serial fallback of ParallelReader)
 func InputBufLengthOption(len int) Option {
 	return func(a applier) error {
 		if len < MinBufferLength {
@@ -213,6 +245,8 @@ func InputBufLengthOption(len int) Option {
 		switch z := a.(type) {
 		case *Reader:
 			z.p.InputBufLength = len
+		case *ParallelReader:
+			z.p.InputBufLength = len
 		default:
 			return ErrApplyInvalidType
 		}
@@ -238,6 +272,121 @@ func BounceBufferLengthOption(len int) Option {
 	}
 }
 
+// Number of compressed output buffers in flight to the output stream (Writer)
+// Compression of the next buffer overlaps with the write of the previous one, 0 disables pipelining
+func PipelineDepthOption(n int) Option {
+	return func(a applier) error {
+		if n < 0 {
+			return ErrParamPipelineDepth
+		}
+
+		switch z := a.(type) {
+		case *Writer:
+			z.p.PipelineDepth = n
+		default:
+			return ErrApplyInvalidType
+		}
+
+		return nil
+	}
+}
+
+// Prefetches up to depth chunks of chunk bytes of compressed input on a goroutine while the current input
+// decompresses (Reader), bounding read-ahead memory to depth*chunk. 0 disables read-ahead.
+// Errors and the end of the input are returned by Read once the data read before them is consumed,
+// Close waits for a read from the input stream in progress.
+func ReadAheadOption(depth int, chunk int) Option {
+	return func(a applier) error {
+		if depth < 0 || (depth > 0 && chunk <= 0) {
+			return ErrParamReadAhead
+		}
+
+		switch z := a.(type) {
+		case *Reader:
+			z.p.ReadAheadDepth = depth
+			z.p.ReadAheadChunk = chunk
+		default:
+			return ErrApplyInvalidType
+		}
+
+		return nil
+	}
+}
+
+// Uncompressed size of each independently compressed block (ParallelWriter)
+// or compressed size of each batch of members decompressed on one session (ParallelReader)
+func BlockSizeOption(size int) Option {
+	return func(a applier) error {
+		if size < MinBlockSize {
+			return ErrParamBlockSize
+		}
+
+		switch z := a.(type) {
+		case *ParallelWriter:
+			z.p.BlockSize = size
+		case *ParallelReader:
+			z.p.BlockSize = size
+		default:
+			return ErrApplyInvalidType
+		}
+
+		return nil
+	}
+}
+
+// Number of QATzip sessions working on blocks concurrently (ParallelWriter, ParallelReader)
+func WorkersOption(n int) Option {
+	return func(a applier) error {
+		if n <= 0 {
+			return ErrParamWorkers
+		}
+
+		switch z := a.(type) {
+		case *ParallelWriter:
+			z.p.Workers = n
+		case *ParallelReader:
+			z.p.Workers = n
+		default:
+			return ErrApplyInvalidType
+		}
+
+		return nil
+	}
+}
+
+// Appends a seek table of the independently compressed blocks, read by SeekableReader (ParallelWriter)
+func SeekableOption(enable bool) Option {
+	return func(a applier) error {
+		switch z := a.(type) {
+		case *ParallelWriter:
+			z.p.Seekable = booltoInt(enable)
+		default:
+			return ErrApplyInvalidType
+		}
+
+		return nil
+	}
+}
+
+// Stores input whose sampled entropy is close to 8 bits per byte (already compressed or encrypted data) as
+// DEFLATE stored blocks, LZ4 uncompressed blocks or ZSTD raw blocks without sending it to QATzip (Writer, ParallelWriter).
+// Raw DEFLATE, Deflate48 and ZSTD with checksums or a window log are always compressed. A Writer ends an open
+// ZSTD frame before storing input, which is then written as a frame of its own.
+func StoreIncompressibleOption(enable bool) Option {
+	return func(a applier) error {
+		switch z := a.(type) {
+		case *Writer:
+			z.p.StoreIncompressible = booltoInt(enable)
+		case *ParallelWriter:
+			z.p.StoreIncompressible = booltoInt(enable)
+		default:
+			return ErrApplyInvalidType
+		}
+
+		return nil
+	}
+}
+
 // If output buffer is too small (see QZ_BUF_ERROR) increase size of output buffer a factor of len and retry
 // (Reader/Writer)
 func BufferGrowthOption(len int) Option {
@@ -249,8 +398,39 @@ func BufferGrowthOption(len int) Option {
 		switch z := a.(type) {
 		case *Reader:
 			z.p.BufferGrowth = len
+		case *ParallelReader:
+			z.p.BufferGrowth = len
 		case *Writer:
 			z.p.BufferGrowth = len
+		case *ParallelWriter:
+			z.p.BufferGrowth = len
+		default:
+			return ErrApplyInvalidType
+		}
+
+		return nil
+	}
+}
+
+// Hard limit for the size of any buffer grown in response to QZ_BUF_ERROR
+// (Reader, Writer, ParallelWriter, ParallelReader, QzBinding for DecompressBlock and SeekableReader)
+func MaxBufferLengthOption(len int) Option {
+	return func(a applier) error {
+		if len < MinBufferLength {
+			return ErrParamMaxBufferLength
+		}
+
+		switch z := a.(type) {
+		case *Reader:
+			z.p.MaxBufferLength = len
+		case *ParallelReader:
+			z.p.MaxBufferLength = len
+		case *Writer:
+			z.p.MaxBufferLength = len
+		case *ParallelWriter:
+			z.p.MaxBufferLength = len
+		case *QzBinding:
+			z.p.MaxBufferLength = len
 		default:
 			return ErrApplyInvalidType
 		}
@@ -262,12 +442,20 @@ func BufferGrowthOption(len int) Option {
 // Software fallback option
 func SwBackupOption(enable bool) Option {
 	return func(a applier) error {
-		v := booltoInt(enable)
+		// 0 keeps the QATzip default
+		v := -1
+		if enable {
+			v = 1
+		}
 		switch z := a.(type) {
 		case *Reader:
 			z.p.SwBackup = v
+		case *ParallelReader:
+			z.p.SwBackup = v
 		case *Writer:
 			z.p.SwBackup = v
+		case *ParallelWriter:
+			z.p.SwBackup = v
 		case *QzBinding:
 			z.p.SwBackup = v
 		default:
@@ -285,8 +473,12 @@ func SensitiveOption(enable bool) Option {
 		switch z := a.(type) {
 		case *Reader:
 			z.p.IsSensitive = v
+		case *ParallelReader:
+			z.p.IsSensitive = v
 		case *Writer:
 			z.p.IsSensitive = v
+		case *ParallelWriter:
+			z.p.IsSensitive = v
 		case *QzBinding:
 			z.p.IsSensitive = v
 		default:
@@ -303,8 +495,12 @@ func MaxForksOption(max int) Option {
 		switch z := a.(type) {
 		case *Reader:
 			z.p.MaxForks = max
+		case *ParallelReader:
+			z.p.MaxForks = max
 		case *Writer:
 			z.p.MaxForks = max
+		case *ParallelWriter:
+			z.p.MaxForks = max
 		case *QzBinding:
 			z.p.MaxForks = max
 		default:
@@ -321,8 +517,12 @@ func HwBufSizeOption(size int) Option {
 		switch z := a.(type) {
 		case *Reader:
 			z.p.HwBufSize = size
+		case *ParallelReader:
+			z.p.HwBufSize = size
 		case *Writer:
 			z.p.HwBufSize = size
+		case *ParallelWriter:
+			z.p.HwBufSize = size
 		case *QzBinding:
 			z.p.HwBufSize = size
 		default:
@@ -339,8 +539,12 @@ func StreamBufSizeOption(size int) Option {
 		switch z := a.(type) {
 		case *Reader:
 			z.p.StreamBufSize = size
+		case *ParallelReader:
+			z.p.StreamBufSize = size
 		case *Writer:
 			z.p.StreamBufSize = size
+		case *ParallelWriter:
+			z.p.StreamBufSize = size
 		case *QzBinding:
 			z.p.StreamBufSize = size
 		default:
@@ -357,8 +561,12 @@ func SwSwitchThresholdOption(size int) Option {
 		switch z := a.(type) {
 		case *Reader:
 			z.p.SwSwitchThreshold = size
+		case *ParallelReader:
+			z.p.SwSwitchThreshold = size
 		case *Writer:
 			z.p.SwSwitchThreshold = size
+		case *ParallelWriter:
+			z.p.SwSwitchThreshold = size
 		case *QzBinding:
 			z.p.SwSwitchThreshold = size
 		default:
@@ -375,8 +583,12 @@ func ReqCountThresholdOption(n int) Option {
 		switch z := a.(type) {
 		case *Reader:
 			z.p.ReqCountThreshold = n
+		case *ParallelReader:
+			z.p.ReqCountThreshold = n
 		case *Writer:
 			z.p.ReqCountThreshold = n
+		case *ParallelWriter:
+			z.p.ReqCountThreshold = n
 		case *QzBinding:
 			z.p.ReqCountThreshold = n
 		default:
@@ -393,8 +605,12 @@ func WaitCountThresholdOption(n int) Option {
 		switch z := a.(type) {
 		case *Reader:
 			z.p.WaitCountThreshold = n
+		case *ParallelReader:
+			z.p.WaitCountThreshold = n
 		case *Writer:
 			z.p.WaitCountThreshold = n
+		case *ParallelWriter:
+			z.p.WaitCountThreshold = n
 		case *QzBinding:
 			z.p.WaitCountThreshold = n
 		default:
@@ -404,3 +620,165 @@ func WaitCountThresholdOption(n int) Option {
 		return nil
 	}
 }
+
+// ZSTD dictionary (ZSTD only). The dictionary is prepared once and shared by all sessions using it.
+// The QAT sequence producer does not support dictionaries, so compression with a dictionary runs in
+// software (libzstd); decompression is always software.
+func ZstdDictionaryOption(dict *ZstdDictionary) Option {
+	return func(a applier) error {
+		switch z := a.(type) {
+		case *Reader:
+			z.p.ZstdDictionary = dict
+		case *ParallelReader:
+			z.p.ZstdDictionary = dict
+		case *Writer:
+			z.p.ZstdDictionary = dict
+		case *ParallelWriter:
+			z.p.ZstdDictionary = dict
+		case *QzBinding:
+			z.p.ZstdDictionary = dict
+		default:
+			return ErrApplyInvalidType
+		}
+
+		return nil
+	}
+}
+
+// ZSTD compression threads (ZSTD only). libzstd must be built with multithreading support.
+// The QAT sequence producer does not support workers, compression with workers runs in software.
+func ZstdWorkersOption(n int) Option {
+	return func(a applier) error {
+		if n < 0 {
+			return ErrParamZstd
+		}
+
+		switch z := a.(type) {
+		case *Writer:
+			z.p.ZstdWorkers = n
+		case *ParallelWriter:
+			z.p.ZstdWorkers = n
+		case *QzBinding:
+			z.p.ZstdWorkers = n
+		default:
+			return ErrApplyInvalidType
+		}
+
+		return nil
+	}
+}
+
+// Bytes compressed by each ZSTD worker job (ZSTD only, requires ZstdWorkersOption)
+func ZstdJobSizeOption(size int) Option {
+	return func(a applier) error {
+		if size < 0 {
+			return ErrParamZstd
+		}
+
+		switch z := a.(type) {
+		case *Writer:
+			z.p.ZstdJobSize = size
+		case *ParallelWriter:
+			z.p.ZstdJobSize = size
+		case *QzBinding:
+			z.p.ZstdJobSize = size
+		default:
+			return ErrApplyInvalidType
+		}
+
+		return nil
+	}
+}
+
+// ZSTD long distance matching (ZSTD only).
+// The QAT sequence producer does not support long distance matching, compression runs in software.
+func ZstdLongDistanceOption(enable bool) Option {
+	return func(a applier) error {
+		v := booltoInt(enable)
+		switch z := a.(type) {
+		case *Writer:
+			z.p.ZstdLongDistance = v
+		case *ParallelWriter:
+			z.p.ZstdLongDistance = v
+		case *QzBinding:
+			z.p.ZstdLongDistance = v
+		default:
+			return ErrApplyInvalidType
+		}
+
+		return nil
+	}
+}
+
+// ZSTD window size as a power of 2 [10 .. 31] (ZSTD only).
+// Readers must be given the same setting to accept windows larger than 2^27.
+func ZstdWindowLogOption(log int) Option {
+	return func(a applier) error {
+		if log != 0 && (log < 10 || log > 31) {
+			return ErrParamZstd
+		}
+
+		switch z := a.(type) {
+		case *Reader:
+			z.p.ZstdWindowLog = log
+		case *ParallelReader:
+			z.p.ZstdWindowLog = log
+		case *Writer:
+			z.p.ZstdWindowLog = log
+		case *ParallelWriter:
+			z.p.ZstdWindowLog = log
+		case *QzBinding:
+			z.p.ZstdWindowLog = log
+		default:
+			return ErrApplyInvalidType
+		}
+
+		return nil
+	}
+}
+
+// ZSTD frame content checksum (ZSTD only)
+func ZstdChecksumOption(enable bool) Option {
+	return func(a applier) error {
+		v := booltoInt(enable)
+		switch z := a.(type) {
+		case *Writer:
+			z.p.ZstdChecksum = v
+		case *ParallelWriter:
+			z.p.ZstdChecksum = v
+		case *QzBinding:
+			z.p.ZstdChecksum = v
+		default:
+			return ErrApplyInvalidType
+		}
+
+		return nil
+	}
+}
+
+// QAT device sessions are placed on (see Devices), DeviceAuto selects the least loaded device
+// local to the NUMA node of the calling CPU
+func DeviceOption(id int) Option {
+	return func(a applier) error {
+		if id != DeviceAuto && (id < 0 || id >= len(Devices())) {
+			return ErrParamDevice
+		}
+
+		switch z := a.(type) {
+		case *Reader:
+			z.p.Device = id
+		case *ParallelReader:
+			z.p.Device = id
+		case *Writer:
+			z.p.Device = id
+		case *ParallelWriter:
+			z.p.Device = id
+		case *QzBinding:
+			z.p.Device = id
+		default:
+			return ErrApplyInvalidType
+		}
+
+		return nil
+	}
+}
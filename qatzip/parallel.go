@@ -0,0 +1,969 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+package qatzip
+
+import (
+	"bufio"
+	"bytes"
+	"context"
+	"encoding/binary"
+	"hash/crc32"
+	"io"
+	"runtime"
+	"runtime/trace"
+	"sync"
+	"time"
+)
+
+// ParallelWriter implements an io.Writer that splits its input into fixed-size blocks and compresses
+// them concurrently on several QATzip sessions. Each block is emitted as a complete gzip member,
+// LZ4 frame or ZSTD frame, so the output is a standard multi-member stream.
+type ParallelWriter struct {
+	w         io.Writer
+	closed    bool
+	started   bool
+	p         params
+	block     *parallelBlock      // block being filled by Write
+	jobs      chan *parallelBlock // blocks waiting for a worker
+	ordered   chan *parallelBlock // blocks waiting for output, in stream order
+	free      chan *parallelBlock // blocks returned by the output goroutine
+	allocated int                 // blocks created so far (at most 2 * Workers + 1)
+	workers   sync.WaitGroup
+	done      chan struct{} // closed when the output goroutine exits
+	mu        sync.Mutex
+	err       error       // first error returned by a worker or w
+	crc       uint32      // CRC-32 of the data written so far, owned by the output goroutine until done
+	index     []seekEntry // blocks written so far (SeekableOption), owned by the output goroutine until done
+	ctx       context.Context
+	task      *trace.Task
+	perf      *Perf // counters owned by the caller
+	outPerf   Perf  // counters owned by the output goroutine until done
+}
+
+// Block of input in flight through a ParallelWriter or ParallelReader
+type parallelBlock struct {
+	in       []byte
+	own      []byte // input buffer of the block while in refers to caller memory (ParallelWriter)
+	out      []byte
+	n        int    // bytes produced in out
+	off      int    // bytes of out already returned (ParallelReader)
+	size     int    // expected uncompressed size of in (ParallelReader)
+	crc      uint32 // CRC-32 of the uncompressed data
+	stored   bool   // in was stored without compression (ParallelWriter)
+	engineNS uint64 // time (ns) spent in QATzip
+	err      error
+	done     chan struct{}
+}
+
+// NewParallelWriter creates a new ParallelWriter with output io.Writer w
+func NewParallelWriter(w io.Writer) *ParallelWriter {
+	z := new(ParallelWriter)
+	z.closed = true
+	z.p = defaultParams()
+	z.w = w
+	return z
+}
+
+// Apply options to ParallelWriter
+func (z *ParallelWriter) Apply(options ...Option) (err error) {
+	if z.started {
+		err = ErrApplyPostInit
+		return
+	}
+
+	for _, op := range options {
+		if err = op(z); err != nil {
+			return
+		}
+	}
+	return
+}
+
+// Reset discards current state, loads applied options, and restarts the worker sessions
+func (z *ParallelWriter) Reset(w io.Writer) (err error) {
+	z.Close()
+	z.err = nil
+
+	if z.p.Algorithm == DEFLATE && z.p.DataFmtDeflate == DeflateRaw {
+		z.err = ErrParamParallelFmt
+		return z.err
+	}
+	if z.p.Seekable != 0 {
+		if z.err = checkSeekable(z.p); z.err != nil {
+			return z.err
+		}
+	}
+
+	if z.p.DebugLevel == None {
+		z.p.DebugLevel = getTraceLevel()
+	}
+
+	z.ctx, z.task = trace.NewTask(context.Background(), "Qz parallel io.Writer")
+
+	sessions := make([]*QzBinding, z.p.Workers)
+	for i := range sessions {
+		if sessions[i], err = acquireSession(z.p); err != nil {
+			for _, q := range sessions[:i] {
+				releaseSession(q)
+			}
+			z.task.End()
+			z.err = err
+			return
+		}
+	}
+
+	depth := 2*z.p.Workers + 1
+	z.w = w
+	z.closed = false
+	z.started = true
+	z.block = nil
+	z.allocated = 0
+	z.crc = 0
+	z.index = z.index[:0]
+	z.perf = new(Perf)
+	z.outPerf = Perf{}
+	z.jobs = make(chan *parallelBlock, depth)
+	z.ordered = make(chan *parallelBlock, depth)
+	z.free = make(chan *parallelBlock, depth)
+	z.done = make(chan struct{})
+
+	for _, q := range sessions {
+		q.perf = z.perf
+		z.workers.Add(1)
+		go z.work(q)
+	}
+	go z.output()
+
+	return
+}
+
+// Compresses blocks on session q until the job queue is closed
+func (z *ParallelWriter) work(q *QzBinding) {
+	defer z.workers.Done()
+	if q.device != DeviceAuto {
+		runtime.LockOSThread()
+		if !bindThread(q.device) {
+			defer runtime.UnlockOSThread()
+		}
+	}
+	defer releaseSession(q)
+
+	store := z.p.StoreIncompressible != 0 && storeSupported(z.p)
+	for b := range z.jobs {
+		b.stored = store && incompressible(b.in)
+		if b.stored {
+			b.out, b.n, b.crc = storeBlock(z.p, b.in, b.out)
+			b.engineNS = 0
+			b.done <- struct{}{}
+			continue
+		}
+
+		r := startRegion(z.ctx, "Qz(2) Compress")
+		t1 := time.Now().UnixNano()
+		b.out, b.n, b.crc, b.err = compressBlock(q, b.in, b.out, z.p.BufferGrowth, z.p.MaxBufferLength)
+		t2 := time.Now().UnixNano()
+		b.engineNS = uint64(t2 - t1)
+		endRegion(r)
+
+		if traceOn(Med, q) {
+			traceLogf(Med, q, z.ctx, "[block->qat] i:%v o:%v err:%v", len(b.in), b.n, b.err)
+		}
+		b.done <- struct{}{}
+	}
+}
+
+// Writes compressed blocks to w in stream order
+func (z *ParallelWriter) output() {
+	defer close(z.done)
+
+	for b := range z.ordered {
+		<-b.done
+
+		if b.err != nil {
+			z.setError(b.err)
+		} else if z.error() == nil {
+			r := startRegion(z.ctx, "Qz(3) Output Stream")
+			t1 := time.Now().UnixNano()
+			_, err := z.w.Write(b.out[:b.n])
+			t2 := time.Now().UnixNano()
+			z.outPerf.WriteTimeNS += uint64(t2 - t1)
+			endRegion(r)
+
+			if err != nil {
+				z.setError(err)
+			}
+			z.crc = CRC32Combine(z.crc, b.crc, int64(len(b.in)))
+			if z.p.Seekable != 0 {
+				z.index = append(z.index, seekEntry{csize: uint32(b.n), usize: uint32(len(b.in)), crc: b.crc})
+			}
+			z.outPerf.BytesOut += uint64(b.n)
+			if b.stored {
+				z.outPerf.BytesStored += uint64(len(b.in))
+			}
+		}
+		z.outPerf.EngineTimeNS += b.engineNS
+
+		if b.own != nil {
+			b.in, b.own = b.own, nil
+		}
+		b.in = b.in[:0]
+		z.free <- b
+	}
+}
+
+func (z *ParallelWriter) setError(err error) {
+	z.mu.Lock()
+	if z.err == nil {
+		z.err = err
+	}
+	z.mu.Unlock()
+}
+
+// First error reported by a worker or the output stream
+func (z *ParallelWriter) error() error {
+	z.mu.Lock()
+	defer z.mu.Unlock()
+	return z.err
+}
+
+// Returns an empty block, waiting for the output goroutine if all blocks are in flight
+func (z *ParallelWriter) getBlock() *parallelBlock {
+	select {
+	case b := <-z.free:
+		return b
+	default:
+	}
+
+	if z.allocated < cap(z.free) {
+		z.allocated++
+		return &parallelBlock{
+			in:   make([]byte, 0, z.p.BlockSize),
+			out:  make([]byte, CompressBound(z.p.Algorithm, z.p.BlockSize)),
+			done: make(chan struct{}, 1),
+		}
+	}
+	return <-z.free
+}
+
+// Queues the current block for compression
+func (z *ParallelWriter) submit() {
+	b := z.block
+	z.block = nil
+	z.ordered <- b
+	z.jobs <- b
+}
+
+// Write() copies data from p into blocks and queues full blocks for compression
+func (z *ParallelWriter) Write(p []byte) (n int, err error) {
+	if !z.started {
+		if err = z.Reset(z.w); err != nil {
+			return 0, err
+		}
+	} else if z.closed {
+		return 0, ErrWriterClosed
+	}
+
+	if err = z.error(); err != nil {
+		return 0, err
+	}
+
+	r := startRegion(z.ctx, "Qz(1) Write()")
+	defer endRegion(r)
+
+	for n < len(p) {
+		if z.block == nil {
+			z.block = z.getBlock()
+		}
+
+		b := z.block
+		t1 := time.Now().UnixNano()
+		nc := copy(b.in[len(b.in):cap(b.in)], p[n:])
+		b.in = b.in[:len(b.in)+nc]
+		t2 := time.Now().UnixNano()
+		z.perf.CopyTimeNS += uint64(t2 - t1)
+		z.perf.BytesIn += uint64(nc)
+		n += nc
+
+		if len(b.in) == cap(b.in) {
+			z.submit()
+			if err = z.error(); err != nil {
+				return n, err
+			}
+		}
+	}
+
+	return n, nil
+}
+
+// Compresses p in blocks that refer to p instead of copying it, p must not change until Close
+func (z *ParallelWriter) writeInPlace(p []byte) (err error) {
+	if !z.started {
+		if err = z.Reset(z.w); err != nil {
+			return err
+		}
+	} else if z.closed {
+		return ErrWriterClosed
+	}
+	if z.block != nil && len(z.block.in) > 0 {
+		z.submit()
+	}
+
+	for off := 0; off < len(p); off += z.p.BlockSize {
+		if err = z.error(); err != nil {
+			return err
+		}
+		if z.block == nil {
+			z.block = z.getBlock()
+		}
+		b := z.block
+		b.own = b.in
+		b.in = p[off:minInt(off+z.p.BlockSize, len(p))]
+		z.perf.BytesIn += uint64(len(b.in))
+		z.submit()
+	}
+
+	return z.error()
+}
+
+// Close compresses the remaining data, waits for all blocks to be written and releases the sessions
+func (z *ParallelWriter) Close() (err error) {
+	if z.closed {
+		return z.err
+	}
+
+	defer z.task.End()
+	defer metricsAddStream(z.perf)
+	z.closed = true
+
+	if z.block != nil && len(z.block.in) > 0 {
+		z.submit()
+	}
+
+	close(z.jobs)
+	close(z.ordered)
+	z.workers.Wait()
+	<-z.done
+
+	z.perf.WriteTimeNS += z.outPerf.WriteTimeNS
+	z.perf.BytesOut += z.outPerf.BytesOut
+	z.perf.BytesStored += z.outPerf.BytesStored
+	z.perf.EngineTimeNS += z.outPerf.EngineTimeNS
+
+	if z.err == nil && z.perf.BytesIn == 0 {
+		var buf []byte
+		r := startRegion(z.ctx, "Qz(5) Empty Buffer")
+		if buf, z.err = emptyStream(z.p); z.err == nil {
+			_, z.err = z.w.Write(buf)
+		}
+		endRegion(r)
+	}
+
+	if z.err == nil && z.p.Seekable != 0 {
+		table := appendSeekTable(nil, z.p.Algorithm, z.index)
+		if _, z.err = z.w.Write(table); z.err == nil {
+			z.perf.BytesOut += uint64(len(table))
+		}
+	}
+
+	return z.err
+}
+
+// CRC32 returns the CRC-32 (IEEE) of all uncompressed data written, valid after Close
+func (z *ParallelWriter) CRC32() uint32 {
+	return z.crc
+}
+
+// Get performance counters from ParallelWriter, valid after Close
+func (z *ParallelWriter) GetPerf() Perf {
+	return *z.perf
+}
+
+// Compresses in as a complete member/frame into out, growing out up to max bytes if required.
+// CRCs come from QATzip for DEFLATE and are computed in software for LZ4 and ZSTD.
+func compressBlock(q *QzBinding, in []byte, out []byte, growth int, max int) (o []byte, n int, crc uint32, err error) {
+	var c uint64
+
+	q.SetLast(true)
+	for consumed := 0; consumed < len(in); {
+		i, p, err := q.CompressCRC(in[consumed:], out[n:], &c)
+		if err == ErrBuffer || (err == nil && i == 0) {
+			if len(out) >= max {
+				return out, 0, 0, ErrBuffer
+			}
+			growth *= 2
+			t := make([]byte, minInt(len(out)+growth, max))
+			copy(t, out[:n])
+			out = t
+			continue
+		}
+		if err != nil {
+			return out, 0, 0, err
+		}
+		consumed += i
+		n += p
+	}
+
+	// a multithreaded ZSTD frame may end with more output than fits
+	for q.Pending() {
+		if n == len(out) {
+			if len(out) >= max {
+				return out, 0, 0, ErrBuffer
+			}
+			growth *= 2
+			t := make([]byte, minInt(len(out)+growth, max))
+			copy(t, out[:n])
+			out = t
+		}
+		p, err := q.finish(out[n:])
+		if err != nil {
+			return out, 0, 0, err
+		}
+		n += p
+	}
+
+	if q.p.Algorithm == DEFLATE {
+		crc = uint32(c)
+	} else {
+		crc = crc32.ChecksumIEEE(in)
+	}
+
+	return out, n, crc, nil
+}
+
+// ParallelReader implements an io.Reader that locates gzip members, LZ4 frames or ZSTD frames
+// from their headers and decompresses them concurrently on several QATzip sessions.
+// Output is returned in stream order. DEFLATE members must carry the QATzip extended header
+// (DeflateGzipExt), input whose member boundaries cannot be determined is decompressed serially.
+type ParallelReader struct {
+	r       io.Reader
+	br      *bufio.Reader
+	closed  bool
+	started bool
+	err     error
+	p       params
+	scan    memberScanner
+	block   *parallelBlock      // block being scanned
+	cur     *parallelBlock      // block being returned by Read
+	jobs    chan *parallelBlock // blocks waiting for a worker
+	ordered []*parallelBlock    // blocks in flight, in stream order
+	free    []*parallelBlock    // blocks available for reuse
+	workers sync.WaitGroup
+	eof     bool    // all input has been scanned
+	limit   int     // bytes the member being scanned may extend the block to
+	carry   []byte  // member scanned past the end of the previous block, starts the next one
+	rest    []byte  // input following the last complete member, decompressed serially
+	serial  *Reader // serial Reader for input that cannot be scanned
+	crc     uint32  // CRC-32 of the data returned so far
+	ctx     context.Context
+	task    *trace.Task
+	perf    *Perf
+}
+
+// NewParallelReader creates a new ParallelReader with input io.Reader r
+func NewParallelReader(r io.Reader) (*ParallelReader, error) {
+	z := new(ParallelReader)
+	z.closed = true
+	z.p = defaultParams()
+	z.r = r
+	return z, nil
+}
+
+// Apply options to ParallelReader
+func (z *ParallelReader) Apply(options ...Option) (err error) {
+	if z.started {
+		err = ErrApplyPostInit
+		return
+	}
+
+	for _, op := range options {
+		if err = op(z); err != nil {
+			return
+		}
+	}
+	return
+}
+
+// Reset discards current state, loads applied options, and restarts the worker sessions
+func (z *ParallelReader) Reset(r io.Reader) (err error) {
+	z.Close()
+	z.err = nil
+
+	if z.p.DebugLevel == None {
+		z.p.DebugLevel = getTraceLevel()
+	}
+
+	z.ctx, z.task = trace.NewTask(context.Background(), "Qz parallel io.Reader")
+
+	z.r = r
+	z.br = bufio.NewReader(r)
+	z.block = nil
+	z.cur = nil
+	z.ordered = nil
+	z.carry = nil
+	z.rest = nil
+	z.serial = nil
+	z.crc = 0
+	z.perf = new(Perf)
+	z.started = true
+	z.closed = false
+
+	// only QATzip extended gzip headers record member lengths
+	z.eof = z.p.Algorithm == DEFLATE && z.p.DataFmtDeflate != DeflateGzipExt
+
+	z.scan = memberScanner{
+		alg:    z.p.Algorithm,
+		ensure: z.ensure,
+		buf:    func() []byte { return z.block.in },
+	}
+
+	z.jobs = make(chan *parallelBlock, 2*z.p.Workers)
+	for i := 0; i < z.p.Workers; i++ {
+		q, err := acquireSession(z.p)
+		if err != nil {
+			z.err = err
+			z.Close()
+			return err
+		}
+		q.perf = z.perf
+		z.workers.Add(1)
+		go z.work(q)
+	}
+
+	return nil
+}
+
+// Decompresses blocks on session q until the job queue is closed
+func (z *ParallelReader) work(q *QzBinding) {
+	defer z.workers.Done()
+	if q.device != DeviceAuto {
+		runtime.LockOSThread()
+		if !bindThread(q.device) {
+			defer runtime.UnlockOSThread()
+		}
+	}
+	defer releaseSession(q)
+
+	for b := range z.jobs {
+		r := startRegion(z.ctx, "Qz(2) Decompress")
+		t1 := time.Now().UnixNano()
+		b.out, b.n, b.err = decompressBlock(q, b.in, b.out, b.size, z.p.MaxBufferLength)
+		if b.err == nil {
+			b.crc = blockCRC(z.p.Algorithm, b.in, b.out[:b.n])
+		}
+		t2 := time.Now().UnixNano()
+		b.engineNS = uint64(t2 - t1)
+		endRegion(r)
+
+		if traceOn(Med, q) {
+			traceLogf(Med, q, z.ctx, "[block->qat] i:%v o:%v err:%v", len(b.in), b.n, b.err)
+		}
+		b.done <- struct{}{}
+	}
+}
+
+// Makes the first n bytes of the block being scanned available, growing it as data arrives
+func (z *ParallelReader) ensure(n int) error {
+	if n > z.limit {
+		return errNotScannable
+	}
+
+	b := z.block
+	for len(b.in) < n {
+		if len(b.in) == cap(b.in) {
+			t := make([]byte, len(b.in), 2*cap(b.in))
+			copy(t, b.in)
+			b.in = t
+		}
+
+		m := n
+		if m > cap(b.in) {
+			m = cap(b.in)
+		}
+
+		rr := startRegion(z.ctx, "Qz(3) Input Stream")
+		t1 := time.Now().UnixNano()
+		nr, err := io.ReadFull(z.br, b.in[len(b.in):m])
+		t2 := time.Now().UnixNano()
+		z.perf.ReadTimeNS += uint64(t2 - t1)
+		endRegion(rr)
+
+		b.in = b.in[:len(b.in)+nr]
+		if err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// Returns a block for scanning, reusing one that has been fully read
+func (z *ParallelReader) getBlock() *parallelBlock {
+	if n := len(z.free); n > 0 {
+		b := z.free[n-1]
+		z.free = z.free[:n-1]
+		return b
+	}
+	return &parallelBlock{
+		in:   make([]byte, 0, z.p.BlockSize),
+		done: make(chan struct{}, 1),
+	}
+}
+
+// Scans members into the next block until it holds at least BlockSize bytes and queues it for decompression.
+// Scanning stops at the end of the input or at the first member whose length cannot be determined or that is
+// too large for a block (compressed beyond CompressBound of BlockSize, or uncompressed beyond MaxBufferLength).
+func (z *ParallelReader) scanBlock() error {
+	z.block = z.getBlock()
+	b := z.block
+	b.in = append(b.in[:0], z.carry...)
+	b.size = 0
+	z.carry = nil
+
+	exact := true
+	start := 0
+	for start < z.p.BlockSize {
+		z.limit = start + CompressBound(z.p.Algorithm, z.p.BlockSize)
+		size, usize, err := z.scan.next(start)
+		if err == nil && usize >= z.p.MaxBufferLength {
+			err = errNotScannable
+		}
+		if err != nil {
+			if err == io.EOF && len(b.in) == start {
+				// clean end of input on a member boundary
+			} else if err != errNotScannable && err != io.EOF && err != io.ErrUnexpectedEOF {
+				return err
+			} else {
+				z.rest = append([]byte(nil), b.in[start:]...)
+			}
+			b.in = b.in[:start]
+			z.eof = true
+			break
+		}
+		if usize < 0 {
+			usize = 4 * size
+			exact = false
+		}
+		if start > 0 && b.size+usize >= z.p.MaxBufferLength {
+			// keep the output of the block within MaxBufferLength
+			z.carry = append([]byte(nil), b.in[start:start+size]...)
+			break
+		}
+		b.size += usize
+		start += size
+	}
+
+	// members ending in the bytes read ahead are not part of this block
+	b.in = b.in[:start]
+	z.block = nil
+
+	// estimated sizes only size the output buffer
+	if !exact {
+		if len(b.out) < b.size {
+			b.out = make([]byte, minInt(b.size, z.p.MaxBufferLength))
+		}
+		b.size = -1
+	}
+
+	if start == 0 {
+		z.free = append(z.free, b)
+		return nil
+	}
+
+	z.perf.BytesIn += uint64(start)
+	z.ordered = append(z.ordered, b)
+	z.jobs <- b
+	return nil
+}
+
+// Read() decompresses members ahead of the caller and returns their output in stream order
+func (z *ParallelReader) Read(p []byte) (n int, err error) {
+	if err = z.start(); err != nil {
+		return 0, err
+	}
+
+	r := startRegion(z.ctx, "Qz(1) Read()")
+	defer endRegion(r)
+
+	out, err := z.next()
+	if err != nil {
+		return 0, err
+	}
+	if out != nil {
+		t1 := time.Now().UnixNano()
+		n = copy(p, out)
+		t2 := time.Now().UnixNano()
+		z.perf.CopyTimeNS += uint64(t2 - t1)
+		z.cur.off += n
+		return n, nil
+	}
+
+	if s := z.serialReader(); s != nil {
+		n, err = s.Read(p)
+		z.crc = crc32.Update(z.crc, crc32.IEEETable, p[:n])
+		if err != nil && err != io.EOF {
+			z.err = err
+		}
+		return n, err
+	}
+
+	return 0, io.EOF
+}
+
+// WriteTo writes the decompressed blocks to w in stream order without copying them
+func (z *ParallelReader) WriteTo(w io.Writer) (n int64, err error) {
+	if err = z.start(); err != nil {
+		return 0, err
+	}
+
+	r := startRegion(z.ctx, "Qz(1) WriteTo()")
+	defer endRegion(r)
+
+	for {
+		out, err := z.next()
+		if err != nil {
+			return n, err
+		}
+		if out == nil {
+			break
+		}
+
+		rw := startRegion(z.ctx, "Qz(4) Output Stream")
+		t1 := time.Now().UnixNano()
+		nw, err := w.Write(out)
+		t2 := time.Now().UnixNano()
+		z.perf.WriteTimeNS += uint64(t2 - t1)
+		endRegion(rw)
+
+		z.cur.off += nw
+		n += int64(nw)
+		if err == nil && nw < len(out) {
+			err = io.ErrShortWrite
+		}
+		if err != nil {
+			z.err = err
+			return n, err
+		}
+	}
+
+	if s := z.serialReader(); s != nil {
+		m, err := s.WriteTo(crcWriter{w: w, crc: &z.crc})
+		n += m
+		if err != nil {
+			z.err = err
+		}
+		return n, err
+	}
+
+	return n, nil
+}
+
+// CRC32 returns the CRC-32 (IEEE) of the data returned so far. For DEFLATE it is combined from the
+// CRCs recorded in the gzip member trailers, for LZ4 and ZSTD the workers compute it block by block.
+func (z *ParallelReader) CRC32() uint32 {
+	return z.crc
+}
+
+// Updates crc with the data written through w
+type crcWriter struct {
+	w   io.Writer
+	crc *uint32
+}
+
+func (c crcWriter) Write(p []byte) (n int, err error) {
+	n, err = c.w.Write(p)
+	*c.crc = crc32.Update(*c.crc, crc32.IEEETable, p[:n])
+	return n, err
+}
+
+// Starts the workers on first use, returns the first error
+func (z *ParallelReader) start() error {
+	if z.err != nil {
+		return z.err
+	}
+
+	if !z.started {
+		z.err = z.Reset(z.r)
+		return z.err
+	} else if z.closed {
+		return ErrReaderClosed
+	}
+	return nil
+}
+
+// Returns the unread output of the current block, waiting for the next block once it has been read.
+// Returns nil once the output of all scanned members has been returned.
+func (z *ParallelReader) next() ([]byte, error) {
+	for {
+		// keep the workers busy
+		for !z.eof && len(z.ordered) < cap(z.jobs) {
+			if z.err = z.scanBlock(); z.err != nil {
+				return nil, z.err
+			}
+		}
+
+		if z.cur != nil && z.cur.off < z.cur.n {
+			return z.cur.out[z.cur.off:z.cur.n], nil
+		}
+
+		if z.cur != nil {
+			z.free = append(z.free, z.cur)
+			z.cur = nil
+		}
+
+		if len(z.ordered) == 0 {
+			return nil, nil
+		}
+
+		b := z.ordered[0]
+		z.ordered = z.ordered[1:]
+		<-b.done
+		z.perf.BytesOut += uint64(b.n)
+		z.perf.EngineTimeNS += b.engineNS
+		if b.err != nil {
+			z.err = b.err
+			return nil, z.err
+		}
+		z.crc = CRC32Combine(z.crc, b.crc, int64(b.n))
+		b.off = 0
+		z.cur = b
+	}
+}
+
+// Returns the CRC-32 of the decompressed members in, combined from the gzip trailers for DEFLATE
+func blockCRC(alg Algorithm, in []byte, out []byte) (crc uint32) {
+	if alg != DEFLATE {
+		return crc32.ChecksumIEEE(out)
+	}
+
+	s := memberScanner{
+		alg: alg,
+		ensure: func(n int) error {
+			if n > len(in) {
+				return ErrData
+			}
+			return nil
+		},
+		buf: func() []byte { return in },
+	}
+	for start := 0; start < len(in); {
+		size, usize, err := s.next(start)
+		if err != nil || usize < 0 {
+			return crc32.ChecksumIEEE(out)
+		}
+		crc = CRC32Combine(crc, binary.LittleEndian.Uint32(in[start+size-8:]), int64(usize))
+		start += size
+	}
+	return crc
+}
+
+// Returns the serial Reader for input that cannot be split into members, nil if there is none
+func (z *ParallelReader) serialReader() *Reader {
+	if z.serial == nil && z.rest == nil && z.perf.BytesIn > 0 {
+		return nil
+	}
+	if z.serial == nil {
+		z.serial, _ = NewReader(io.MultiReader(bytes.NewReader(z.rest), z.br))
+		z.serial.p = z.p
+		z.serial.nested = true
+		z.rest = nil
+	}
+	return z.serial
+}
+
+// Close waits for in-flight members and releases the sessions
+func (z *ParallelReader) Close() error {
+	if z.closed {
+		return z.err
+	}
+
+	defer z.task.End()
+	defer metricsAddStream(z.perf)
+	z.closed = true
+
+	close(z.jobs)
+	z.workers.Wait()
+
+	if z.serial != nil {
+		if err := z.serial.Close(); z.err == nil {
+			z.err = err
+		}
+		sp := z.serial.GetPerf()
+		z.perf.add(&sp)
+		z.serial = nil
+	}
+
+	z.ordered = nil
+	z.free = nil
+	z.cur = nil
+
+	return z.err
+}
+
+// Get performance counters from ParallelReader
+func (z *ParallelReader) GetPerf() Perf {
+	return *z.perf
+}
+
+// Decompresses the complete members in in into the capacity of out, growing out if required.
+// size is the expected uncompressed length of in (-1 if unknown), out never grows beyond max bytes.
+func decompressBlock(q *QzBinding, in []byte, out []byte, size int, max int) (o []byte, n int, err error) {
+	// size comes from member/frame headers and is not trusted beyond max
+	if size >= max {
+		return out, 0, ErrBuffer
+	}
+	out = out[:cap(out)]
+	if len(out) < size || len(out) == 0 {
+		out = make([]byte, size+1)
+	}
+	grow := func() error {
+		if len(out) >= max {
+			return ErrBuffer
+		}
+		t := make([]byte, minInt(2*len(out), max))
+		copy(t, out[:n])
+		out = t
+		return nil
+	}
+	defer q.resetStream()
+
+	// complete ZSTD frames of known size are decoded in a single call
+	if q.p.Algorithm == ZSTD && size > 0 && !q.inFrame() {
+		_, p, err := q.decompressFrames(in, out)
+		if err != nil {
+			return out, 0, err
+		}
+		if p != size {
+			return out, 0, ErrData
+		}
+		return out, p, nil
+	}
+
+	q.SetLast(true)
+	for consumed := 0; ; {
+		if n == len(out) {
+			if err := grow(); err != nil {
+				return out, 0, err
+			}
+		}
+
+		c, p, err := q.DecompressStream(in[consumed:], out[n:])
+		if err == ErrBuffer {
+			if err := grow(); err != nil {
+				return out, 0, err
+			}
+			continue
+		}
+		if err != nil {
+			return out, 0, err
+		}
+		consumed += c
+		n += p
+
+		// output of the expected size may fill out exactly, further input or output grows it
+		if consumed == len(in) && !q.Pending() && (n < len(out) || n == size) {
+			return out, n, nil
+		}
+		if c == 0 && p == 0 && n < len(out) {
+			return out, 0, ErrData
+		}
+	}
+}
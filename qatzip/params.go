@@ -12,10 +12,14 @@ type InputBufferMode int
 const (
 	DefaultCompression        = 1
 	MinBufferLength           = 128 * 1024
-	DefaultBufferLength       = 128 * 1024 * 1024
+	DefaultBufferLength       = 2 * 1024 * 1024
+	DefaultMaxBufferLength    = 128 * 1024 * 1024
 	DefaultBufferGrowth       = 1024 * 1024
 	DefaultBounceBufferLength = 512
 	MinBounceBufferLength     = 512
+	DefaultBlockSize          = 1024 * 1024
+	MinBlockSize              = 64 * 1024
+	DefaultParallelWorkers    = 4
 )
 
 const (
@@ -93,15 +97,16 @@ func (dir Direction) isValid() bool {
 }
 
 const (
-	Reserve InputBufferMode = iota // Reserve a portion of the input buffer for last
-	Bounce                         // Bounce all buffers
-	Last                           // Force last=true for all buffers
-	NoLast                         // Force last=false for all buffers
+	Reserve   InputBufferMode = iota // Reserve a portion of the input buffer for last
+	Bounce                           // Bounce all buffers
+	Last                             // Force last=true for all buffers
+	NoLast                           // Force last=false for all buffers
+	DeferLast                        // Compress buffers in place with last=false, Close() terminates the stream
 )
 
 func (mode InputBufferMode) isValid() bool {
 	switch mode {
-	case Reserve, Bounce, Last, NoLast:
+	case Reserve, Bounce, Last, NoLast, DeferLast:
 		return true
 	}
 	return false
@@ -117,26 +122,41 @@ const (
 
 // Configuration parameters for QATgo compression
 type params struct {
-	OutputBufLength    int             // Output buffer size for QAT (for Reader and Writer)
-	InputBufLength     int             // Input buffer size for QAT (for Reader)
-	BufferGrowth       int             // How much to increase output buffer if required (Default 1MB)
-	Direction          Direction       // Configures hardware for compress, decompress, or both (Default: Both)
-	Level              int             // Compression level (Default: 1)
-	Algorithm          Algorithm       // Desired compression algorithm (Default: DEFLATE)
-	SwBackup           int             // Enables software fallback (Default: 1)
-	MaxForks           int             // Maximum forks permitted in the current thread, 0 means no forking permitted (Default: 3)
-	HwBufSize          int             // Default hardware buffer size, must be a power of 2KB (Default: 64KB)
-	StreamBufSize      int             // Stream buffer size between [1KB .. 2MB - 5KB] (Default: 64KB)
-	SwSwitchThreshold  int             // Threshold of compression service's input size for SW failover, if the size of input request is less (Default: 1KB)
-	ReqCountThreshold  int             // Threshold for how many buffer requests it can make on a single thread (Default: 32)
-	WaitCountThreshold int             // When previous try failed, wait for specific number of calls before retrying to open the device (Default: 8)
-	PollingMode        PollingMode     // Settings for busy polling
-	IsSensitive        int             // Enables sensitive mode (Default: 0)
-	HuffmanHdr         HuffmanHdr      // Dynamic or Static Huffman headers (Default: Dynamic)
-	DataFmtDeflate     DeflateFmt      // DEFLATE raw, DEFLATE with gzip or DEFLATE with gzip extended header (Default: gzip ext.)
-	BounceBufferLength int             // Length of the Bounce Buffer (Default: 512)
-	InputBufferMode    InputBufferMode // Settings for input buffer mode
-	DebugLevel         DebugLevel      // Trace Level settings
+	OutputBufLength     int             // Output buffer size for QAT (for Reader and Writer, Default: 2MB)
+	InputBufLength      int             // Input buffer size for QAT (for Reader, Default: 2MB)
+	BufferGrowth        int             // How much to increase output buffer if required (Default 1MB)
+	MaxBufferLength     int             // Hard limit for buffer growth (Default: 128MB)
+	Direction           Direction       // Configures hardware for compress, decompress, or both (Default: Both)
+	Level               int             // Compression level (Default: 1)
+	Algorithm           Algorithm       // Desired compression algorithm (Default: DEFLATE)
+	SwBackup            int             // Enables (1) or disables (-1) software fallback (Default: 1)
+	MaxForks            int             // Maximum forks permitted in the current thread, 0 means no forking permitted (Default: 3)
+	HwBufSize           int             // Default hardware buffer size, must be a power of 2KB (Default: 64KB)
+	StreamBufSize       int             // Stream buffer size between [1KB .. 2MB - 5KB] (Default: 64KB)
+	SwSwitchThreshold   int             // Threshold of compression service's input size for SW failover, if the size of input request is less (Default: 1KB)
+	ReqCountThreshold   int             // Threshold for how many buffer requests it can make on a single thread (Default: 32)
+	WaitCountThreshold  int             // When previous try failed, wait for specific number of calls before retrying to open the device (Default: 8)
+	PollingMode         PollingMode     // Settings for busy polling
+	IsSensitive         int             // Enables sensitive mode (Default: 0)
+	HuffmanHdr          HuffmanHdr      // Dynamic or Static Huffman headers (Default: Dynamic)
+	DataFmtDeflate      DeflateFmt      // DEFLATE raw, DEFLATE with gzip or DEFLATE with gzip extended header (Default: gzip ext.)
+	BounceBufferLength  int             // Length of the Bounce Buffer (Default: 512)
+	InputBufferMode     InputBufferMode // Settings for input buffer mode
+	PipelineDepth       int             // Output buffers in flight to the output stream, 0 writes synchronously (Default: 0)
+	BlockSize           int             // Uncompressed size of each independently compressed block (for ParallelWriter, compressed size of each batch of members for ParallelReader, Default: 1MB)
+	Workers             int             // Number of QATzip sessions working on blocks concurrently (for ParallelWriter and ParallelReader, Default: 4)
+	Seekable            int             // Appends a seek table of the blocks for SeekableReader (for ParallelWriter, Default: 0)
+	ReadAheadDepth      int             // Chunks of compressed input prefetched ahead of decompression, 0 reads synchronously (for Reader, Default: 0)
+	ReadAheadChunk      int             // Length of each prefetched chunk (for Reader)
+	StoreIncompressible int             // Stores input sampled as incompressible without sending it to QATzip (for Writer and ParallelWriter, Default: 0)
+	ZstdDictionary      *ZstdDictionary // Shared ZSTD dictionary, compression with a dictionary is software only (Default: none)
+	ZstdWorkers         int             // ZSTD compression threads, software only (Default: 0, compress in the calling thread)
+	ZstdJobSize         int             // ZSTD bytes compressed per worker job (Default: 0, chosen by libzstd)
+	ZstdLongDistance    int             // Enables ZSTD long distance matching, software only (Default: 0)
+	ZstdWindowLog       int             // ZSTD window size as a power of 2, also the largest window accepted by Reader (Default: 0, chosen by libzstd)
+	ZstdChecksum        int             // Appends a ZSTD content checksum to each frame (Default: 0)
+	Device              int             // QAT device the session is placed on (Default: DeviceAuto, local to the NUMA node of the calling CPU)
+	DebugLevel          DebugLevel      // Trace Level settings
 }
 
 func defaultParams() (p params) {
@@ -147,6 +167,18 @@ func defaultParams() (p params) {
 	p.OutputBufLength = DefaultBufferLength
 	p.InputBufLength = DefaultBufferLength
 	p.BufferGrowth = DefaultBufferGrowth
+	p.MaxBufferLength = DefaultMaxBufferLength
 	p.BounceBufferLength = DefaultBounceBufferLength
+	p.BlockSize = DefaultBlockSize
+	p.Workers = DefaultParallelWorkers
+	p.Device = DeviceAuto
 	return
 }
+
+// Hardware buffer size of the session, the largest input QATzip compresses into one gzip member
+func (p params) hwBufSize() int {
+	if p.HwBufSize <= 0 {
+		return defaultHwBufSize
+	}
+	return p.HwBufSize
+}
@@ -0,0 +1,165 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+package qatzip
+
+/*
+#include "qatzip_internal.h"
+*/
+import "C"
+
+import (
+	"sync"
+	"sync/atomic"
+	"unsafe"
+)
+
+// Process-wide pinned memory, see AllocBuffer and SetPinnedBufferLimit
+var pinned struct {
+	mu    sync.Mutex
+	limit int64                 // pinned bytes the buffer pool may allocate, 0 disables it
+	size  int64                 // pinned bytes allocated by the buffer pool
+	idle  [bufferTiers][][]byte // pool buffers not in use
+	owner map[*byte]bool        // start of every pinned buffer, true if it belongs to the buffer pool
+}
+
+// Allocates n bytes of pinned memory, nil if none is available
+func allocPinned(n int) []byte {
+	p := C.qatzip_malloc_pinned(C.size_t(n))
+	if p == nil {
+		return nil
+	}
+	return unsafe.Slice((*byte)(p), n)
+}
+
+// Records b, the caller holds pinned.mu
+func ownPinned(b []byte, pool bool) {
+	if pinned.owner == nil {
+		pinned.owner = make(map[*byte]bool)
+	}
+	pinned.owner[&b[0]] = pool
+}
+
+// AllocBuffer returns n bytes of pinned, physically contiguous memory on the NUMA node of the calling CPU.
+// QATzip hands pinned buffers to the device directly instead of copying them into its own, which makes them
+// the input and output of choice for CompressBlock, DecompressBlock, QzBinding and Writer.Write.
+// The memory is not managed by the garbage collector and must be released with FreeBuffer.
+// Returns ErrNoMem if no pinned memory is available (no QAT memory driver or the driver is out of memory).
+func AllocBuffer(n int) ([]byte, error) {
+	if n <= 0 {
+		return nil, ErrParams
+	}
+
+	b := allocPinned(n)
+	if b == nil {
+		return nil, ErrNoMem
+	}
+	pinned.mu.Lock()
+	ownPinned(b, false)
+	pinned.mu.Unlock()
+	return b, nil
+}
+
+// FreeBuffer releases a buffer returned by AllocBuffer, b and slices of it must not be used afterwards
+func FreeBuffer(b []byte) error {
+	if cap(b) == 0 {
+		return ErrNotPinned
+	}
+
+	p := &b[:1][0]
+	pinned.mu.Lock()
+	pool, ok := pinned.owner[p]
+	if ok && !pool {
+		delete(pinned.owner, p)
+	}
+	pinned.mu.Unlock()
+
+	if !ok || pool {
+		return ErrNotPinned
+	}
+	C.qatzip_free_pinned(unsafe.Pointer(p))
+	return nil
+}
+
+// SetPinnedBufferLimit lets the process-wide buffer pool allocate up to bytes of pinned memory for the
+// input and output buffers of Writers, Readers, write pipelines and CompressBatch, so QATzip reads and
+// writes them without staging copies. Buffers beyond the limit, or when pinned memory is not available,
+// come from the Go heap. Buffers of Writers and Readers that are never closed are not returned to the pool.
+// 0 (the default) disables pinned pool buffers and frees the idle ones.
+func SetPinnedBufferLimit(bytes int64) error {
+	if bytes < 0 {
+		return ErrParams
+	}
+
+	pinned.mu.Lock()
+	atomic.StoreInt64(&pinned.limit, bytes)
+	var excess [][]byte
+	for t := range pinned.idle {
+		for n := len(pinned.idle[t]); n > 0 && pinned.size > bytes; n-- {
+			b := pinned.idle[t][n-1]
+			pinned.idle[t] = pinned.idle[t][:n-1]
+			delete(pinned.owner, &b[0])
+			atomic.AddInt64(&pinned.size, -int64(cap(b)))
+			excess = append(excess, b)
+		}
+	}
+	pinned.mu.Unlock()
+
+	for _, b := range excess {
+		C.qatzip_free_pinned(unsafe.Pointer(&b[0]))
+	}
+	return nil
+}
+
+// Returns an idle or new pinned buffer of size class t, nil if the pool is disabled, at its limit or out of pinned memory
+func getPinned(t int) []byte {
+	if atomic.LoadInt64(&pinned.limit) == 0 {
+		return nil
+	}
+
+	size := MinBufferLength << t
+	pinned.mu.Lock()
+	defer pinned.mu.Unlock()
+
+	if n := len(pinned.idle[t]); n > 0 {
+		b := pinned.idle[t][n-1]
+		pinned.idle[t] = pinned.idle[t][:n-1]
+		return b
+	}
+	if pinned.size+int64(size) > pinned.limit {
+		return nil
+	}
+	b := allocPinned(size)
+	if b == nil {
+		return nil
+	}
+	ownPinned(b, true)
+	atomic.AddInt64(&pinned.size, int64(size))
+	return b
+}
+
+// Returns b to the pinned buffers if it is one, pinned memory above the limit is freed
+func putPinned(b []byte) bool {
+	if atomic.LoadInt64(&pinned.size) == 0 || cap(b) == 0 {
+		return false
+	}
+
+	b = b[:cap(b)]
+	pinned.mu.Lock()
+	pool, ok := pinned.owner[&b[0]]
+	if !ok || !pool {
+		pinned.mu.Unlock()
+		return ok
+	}
+	if pinned.size <= pinned.limit {
+		t := bufferTier(cap(b))
+		pinned.idle[t] = append(pinned.idle[t], b)
+		pinned.mu.Unlock()
+		return true
+	}
+	delete(pinned.owner, &b[0])
+	atomic.AddInt64(&pinned.size, -int64(cap(b)))
+	pinned.mu.Unlock()
+
+	C.qatzip_free_pinned(unsafe.Pointer(&b[0]))
+	return true
+}
@@ -0,0 +1,229 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+package qatzip
+
+import (
+	"context"
+	"io"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+// Overlaps QAT compression with writes to the output stream.
+// Compressed buffers are handed to a writer goroutine in order, at most depth buffers are in flight.
+type writePipeline struct {
+	w           io.Writer
+	ctx         context.Context
+	work        chan []byte   // compressed buffers waiting to be written, in stream order
+	free        chan []byte   // buffers returned by the writer goroutine
+	done        chan struct{} // closed when the writer goroutine exits
+	allocated   int           // buffers created so far (at most depth)
+	depth       int
+	writeTimeNS uint64 // time (ns) spent writing to w, owned by the writer goroutine until done
+	mu          sync.Mutex
+	err         error // first error returned by w
+}
+
+func newWritePipeline(ctx context.Context, w io.Writer, depth int) *writePipeline {
+	wp := &writePipeline{
+		w:     w,
+		ctx:   ctx,
+		work:  make(chan []byte, depth),
+		free:  make(chan []byte, depth),
+		done:  make(chan struct{}),
+		depth: depth,
+	}
+	go wp.run()
+	return wp
+}
+
+func (wp *writePipeline) run() {
+	defer close(wp.done)
+
+	for b := range wp.work {
+		if wp.error() == nil {
+			r := startRegion(wp.ctx, "Qz(3) Output Stream")
+			t1 := time.Now().UnixNano()
+			_, err := wp.w.Write(b)
+			t2 := time.Now().UnixNano()
+			wp.writeTimeNS += uint64(t2 - t1)
+			endRegion(r)
+
+			if err != nil {
+				wp.mu.Lock()
+				wp.err = err
+				wp.mu.Unlock()
+			}
+		}
+		wp.free <- b[:cap(b)]
+	}
+}
+
+// First error reported by the output stream
+func (wp *writePipeline) error() error {
+	wp.mu.Lock()
+	defer wp.mu.Unlock()
+	return wp.err
+}
+
+// Returns an output buffer of at least n bytes, waiting for a write to complete if all buffers are in flight
+func (wp *writePipeline) get(n int) (b []byte, err error) {
+	if err = wp.error(); err != nil {
+		return nil, err
+	}
+
+	select {
+	case b = <-wp.free:
+	default:
+		if wp.allocated < wp.depth {
+			wp.allocated++
+			return getBuffer(n), nil
+		}
+		b = <-wp.free
+	}
+
+	if len(b) < n {
+		putBuffer(b)
+		b = getBuffer(n)
+	}
+	return b, wp.error()
+}
+
+// Returns an unused output buffer
+func (wp *writePipeline) put(b []byte) {
+	wp.free <- b
+}
+
+// Queues compressed data for writing, b must have been obtained from get
+func (wp *writePipeline) submit(b []byte) {
+	wp.work <- b
+}
+
+// Waits for all queued writes, the caller must not hold any buffer from get
+func (wp *writePipeline) flush() error {
+	bufs := make([][]byte, 0, wp.allocated)
+	for i := 0; i < wp.allocated; i++ {
+		bufs = append(bufs, <-wp.free)
+	}
+	for _, b := range bufs {
+		wp.free <- b
+	}
+	return wp.error()
+}
+
+// Waits for all queued writes, stops the writer goroutine and returns the buffers to the buffer pool
+func (wp *writePipeline) close() (writeTimeNS uint64, err error) {
+	close(wp.work)
+	<-wp.done
+	for len(wp.free) > 0 {
+		putBuffer(<-wp.free)
+	}
+	return wp.writeTimeNS, wp.err
+}
+
+// Overlaps reads from the input stream with QAT decompression.
+// A reader goroutine fills a ring of depth chunks of compressed input ahead of the decompressor.
+type readPipeline struct {
+	r          io.Reader
+	ctx        context.Context
+	ready      chan readChunk // filled chunks in stream order
+	free       chan []byte    // chunks drained by Read
+	stop       chan struct{}  // closed to stop the reader goroutine
+	done       chan struct{}  // closed when the reader goroutine exits
+	cur        []byte         // chunk being drained by Read
+	off        int            // bytes of cur already returned
+	chunk      int            // length of each chunk buffer
+	err        error          // error or io.EOF that ended the input, returned once cur is drained
+	readTimeNS uint64         // time (ns) spent reading from r, updated atomically
+}
+
+type readChunk struct {
+	b   []byte
+	err error
+}
+
+func newReadPipeline(ctx context.Context, r io.Reader, depth int, chunk int) *readPipeline {
+	rp := &readPipeline{
+		r:     r,
+		ctx:   ctx,
+		ready: make(chan readChunk, depth),
+		free:  make(chan []byte, depth),
+		stop:  make(chan struct{}),
+		done:  make(chan struct{}),
+		chunk: chunk,
+	}
+	for i := 0; i < depth; i++ {
+		rp.free <- getBuffer(chunk)
+	}
+	go rp.run()
+	return rp
+}
+
+func (rp *readPipeline) run() {
+	defer close(rp.done)
+
+	for {
+		var b []byte
+		select {
+		case b = <-rp.free:
+		case <-rp.stop:
+			return
+		}
+
+		r := startRegion(rp.ctx, "Qz(0) Read Ahead")
+		t1 := time.Now().UnixNano()
+		n, err := 0, error(nil)
+		for n == 0 && err == nil {
+			n, err = rp.r.Read(b)
+		}
+		t2 := time.Now().UnixNano()
+		atomic.AddUint64(&rp.readTimeNS, uint64(t2-t1))
+		endRegion(r)
+
+		rp.ready <- readChunk{b: b[:n], err: err}
+		if err != nil {
+			return
+		}
+	}
+}
+
+// Read returns prefetched input, waiting for the reader goroutine when no chunk is ready
+func (rp *readPipeline) Read(p []byte) (n int, err error) {
+	for rp.off == len(rp.cur) {
+		if rp.err != nil {
+			return 0, rp.err
+		}
+		if rp.cur != nil {
+			rp.free <- rp.cur[:rp.chunk]
+		}
+		c := <-rp.ready
+		rp.cur, rp.off, rp.err = c.b, 0, c.err
+	}
+
+	n = copy(p, rp.cur[rp.off:])
+	rp.off += n
+	return n, nil
+}
+
+// Time (ns) the reader goroutine has spent reading from r
+func (rp *readPipeline) prefetchTime() uint64 {
+	return atomic.LoadUint64(&rp.readTimeNS)
+}
+
+// Stops the reader goroutine, waiting for a read in progress, and returns the chunks to the buffer pool
+func (rp *readPipeline) close() (readTimeNS uint64) {
+	close(rp.stop)
+	<-rp.done
+	if rp.cur != nil {
+		putBuffer(rp.cur)
+		rp.cur = nil
+	}
+	for len(rp.ready) > 0 {
+		putBuffer((<-rp.ready).b)
+	}
+	for len(rp.free) > 0 {
+		putBuffer(<-rp.free)
+	}
+	return rp.prefetchTime()
+}
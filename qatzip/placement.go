@@ -0,0 +1,210 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+package qatzip
+
+/*
+#include "qatzip_internal.h"
+*/
+import "C"
+
+import (
+	"os"
+	"path/filepath"
+	"sort"
+	"strconv"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"syscall"
+	"unsafe"
+)
+
+const (
+	// DeviceAuto places sessions on the QAT device local to the NUMA node of the calling CPU
+	DeviceAuto = -1
+
+	intelVendorID = "0x8086"
+)
+
+// PCI device IDs of QAT endpoints (physical and virtual functions)
+var qatDeviceIDs = map[string]bool{
+	"0x0435": false, "0x0443": true, // DH895xCC
+	"0x37c8": false, "0x37c9": true, // C62x
+	"0x19e2": false, "0x19e3": true, // C3xxx
+	"0x6f54": false, "0x6f55": true, // D15xx
+	"0x18a0": false, "0x18a1": true, // C4xxx
+	"0x4940": false, "0x4941": true, // 4xxx
+	"0x4942": false, "0x4943": true, // 401xx
+	"0x4944": false, "0x4945": true, // 402xx
+	"0x4946": false, "0x4947": true, // 420xx
+}
+
+// Device is a QAT endpoint found on the PCI bus
+type Device struct {
+	ID       int    // index used by DeviceOption
+	Address  string // PCI address
+	NumaNode int    // NUMA node of the device, -1 if unknown
+	Virtual  bool   // SR-IOV virtual function
+	InFlight int64  // sessions currently checked out on the device
+}
+
+// Session placement state, discovered on first use
+var placement struct {
+	once     sync.Once
+	sysfs    string // sysfs mount point, replaced by tests
+	devices  []Device
+	inFlight []int64
+	next     uint64 // round-robin start among equally loaded devices
+}
+
+func init() {
+	placement.sysfs = "/sys"
+}
+
+// Devices returns the QAT endpoints sessions can be placed on and their in-flight session counts.
+// Physical functions are not listed when virtual functions are present.
+func Devices() []Device {
+	placement.once.Do(discoverDevices)
+
+	devices := make([]Device, len(placement.devices))
+	copy(devices, placement.devices)
+	for i := range devices {
+		devices[i].InFlight = atomic.LoadInt64(&placement.inFlight[i])
+	}
+	return devices
+}
+
+func discoverDevices() {
+	root := filepath.Join(placement.sysfs, "bus/pci/devices")
+	entries, _ := os.ReadDir(root)
+
+	var pf, vf []Device
+	for _, e := range entries {
+		dir := filepath.Join(root, e.Name())
+		if sysfsString(dir, "vendor") != intelVendorID {
+			continue
+		}
+		virtual, ok := qatDeviceIDs[sysfsString(dir, "device")]
+		if !ok {
+			continue
+		}
+		node, err := strconv.Atoi(sysfsString(dir, "numa_node"))
+		if err != nil {
+			node = -1
+		}
+		d := Device{Address: e.Name(), NumaNode: node, Virtual: virtual}
+		if virtual {
+			vf = append(vf, d)
+		} else {
+			pf = append(pf, d)
+		}
+	}
+
+	devices := pf
+	if len(vf) > 0 {
+		devices = vf
+	}
+	sort.Slice(devices, func(i, j int) bool { return devices[i].Address < devices[j].Address })
+	for i := range devices {
+		devices[i].ID = i
+	}
+
+	placement.devices = devices
+	placement.inFlight = make([]int64, len(devices))
+}
+
+func sysfsString(dir string, name string) string {
+	b, _ := os.ReadFile(filepath.Join(dir, name))
+	return strings.TrimSpace(string(b))
+}
+
+// Returns the NUMA node of the CPU the calling thread runs on, -1 if unknown
+func currentNumaNode() int {
+	return int(C.qatzip_numa_node())
+}
+
+// Selects the device for a new session: the requested device, or the least loaded device on the
+// NUMA node of the calling CPU (any device if none is local). Returns DeviceAuto without devices.
+func placeSession(device int) int {
+	placement.once.Do(discoverDevices)
+	if len(placement.devices) == 0 {
+		return DeviceAuto
+	}
+	if device != DeviceAuto {
+		atomic.AddInt64(&placement.inFlight[device], 1)
+		return device
+	}
+
+	node := currentNumaNode()
+	candidates := make([]int, 0, len(placement.devices))
+	for _, d := range placement.devices {
+		if d.NumaNode == node {
+			candidates = append(candidates, d.ID)
+		}
+	}
+	if len(candidates) == 0 {
+		for _, d := range placement.devices {
+			candidates = append(candidates, d.ID)
+		}
+	}
+
+	start := int(atomic.AddUint64(&placement.next, 1) % uint64(len(candidates)))
+	best := candidates[start]
+	for i := 1; i < len(candidates); i++ {
+		c := candidates[(start+i)%len(candidates)]
+		if atomic.LoadInt64(&placement.inFlight[c]) < atomic.LoadInt64(&placement.inFlight[best]) {
+			best = c
+		}
+	}
+	atomic.AddInt64(&placement.inFlight[best], 1)
+	return best
+}
+
+// Ends the in-flight accounting of a session started by placeSession
+func unplaceSession(device int) {
+	if device >= 0 && device < len(placement.inFlight) {
+		atomic.AddInt64(&placement.inFlight[device], -1)
+	}
+}
+
+// Restricts the calling thread to the CPUs of the NUMA node of device, reports whether it did.
+// The caller must hold runtime.LockOSThread and must not unlock a restricted thread,
+// which then exits with the goroutine instead of returning to the scheduler.
+func bindThread(device int) bool {
+	if device < 0 || device >= len(placement.devices) || placement.devices[device].NumaNode < 0 {
+		return false
+	}
+	cpus := nodeCPUs(placement.devices[device].NumaNode)
+	if len(cpus) == 0 {
+		return false
+	}
+
+	mask := make([]uint64, cpus[len(cpus)-1]/64+1)
+	for _, c := range cpus {
+		mask[c/64] |= 1 << (c % 64)
+	}
+	_, _, errno := syscall.RawSyscall(syscall.SYS_SCHED_SETAFFINITY, 0, uintptr(len(mask)*8), uintptr(unsafe.Pointer(&mask[0])))
+	return errno == 0
+}
+
+// Returns the CPUs of a NUMA node in ascending order
+func nodeCPUs(node int) (cpus []int) {
+	list := sysfsString(filepath.Join(placement.sysfs, "devices/system/node", "node"+strconv.Itoa(node)), "cpulist")
+	for _, r := range strings.Split(list, ",") {
+		lo, hi, found := strings.Cut(r, "-")
+		first, err := strconv.Atoi(lo)
+		if err != nil {
+			continue
+		}
+		last := first
+		if found {
+			if last, err = strconv.Atoi(hi); err != nil {
+				continue
+			}
+		}
+		for c := first; c <= last; c++ {
+			cpus = append(cpus, c)
+		}
+	}
+	return cpus
+}
@@ -0,0 +1,252 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+package qatzip
+
+import (
+	"sync"
+)
+
+const (
+	DefaultSessionPoolMinIdle = 0
+	DefaultSessionPoolMaxIdle = 16
+)
+
+// Process-wide pool of started QATzip sessions, keyed by session parameters.
+// Keys without idle sessions are removed so that the pool does not keep a ZstdDictionary reachable.
+type sessionPool struct {
+	mu        sync.Mutex
+	idle      map[params][]*QzBinding
+	prewarmed map[prewarmKey]struct{} // keys whose first use pre-initialized minIdle sessions
+	minIdle   int                     // sessions pre-initialized the first time a key is used
+	maxIdle   int                     // idle sessions retained per key
+}
+
+// Session key with the dictionary identified by its id instead of its pointer
+type prewarmKey struct {
+	p    params
+	dict uint64
+}
+
+var sessions = sessionPool{
+	idle:      make(map[params][]*QzBinding),
+	prewarmed: make(map[prewarmKey]struct{}),
+	minIdle:   DefaultSessionPoolMinIdle,
+	maxIdle:   DefaultSessionPoolMaxIdle,
+}
+
+func newPrewarmKey(key params) prewarmKey {
+	k := prewarmKey{p: key}
+	if key.ZstdDictionary != nil {
+		k.dict = key.ZstdDictionary.id
+		k.p.ZstdDictionary = nil
+	}
+	return k
+}
+
+// Forgets the prewarm state of the sessions of a dictionary that is being freed
+func forgetPrewarmed(dict uint64) {
+	sessions.mu.Lock()
+	for k := range sessions.prewarmed {
+		if k.dict == dict {
+			delete(sessions.prewarmed, k)
+		}
+	}
+	sessions.mu.Unlock()
+}
+
+// Parameters that select a QATzip session (buffer management settings are not part of the session)
+func (p params) sessionKey() params {
+	p.OutputBufLength = 0
+	p.InputBufLength = 0
+	p.BufferGrowth = 0
+	p.MaxBufferLength = 0
+	p.BounceBufferLength = 0
+	p.InputBufferMode = 0
+	p.PipelineDepth = 0
+	p.BlockSize = 0
+	p.Workers = 0
+	p.Seekable = 0
+	p.StoreIncompressible = 0
+	p.ReadAheadDepth = 0
+	p.ReadAheadChunk = 0
+	return p
+}
+
+// Sets the process-wide session pool size.
+// min sessions are pre-initialized the first time a parameter set is used,
+// max idle sessions are retained per parameter set (0 disables pooling).
+func SetSessionPoolSize(min int, max int) error {
+	if min < 0 || max < 0 || min > max {
+		return ErrParams
+	}
+
+	sessions.mu.Lock()
+	sessions.minIdle = min
+	sessions.maxIdle = max
+	var excess []*QzBinding
+	for key, idle := range sessions.idle {
+		if len(idle) > max {
+			excess = append(excess, idle[max:]...)
+			if max == 0 {
+				delete(sessions.idle, key)
+			} else {
+				sessions.idle[key] = idle[:max]
+			}
+		}
+	}
+	sessions.mu.Unlock()
+
+	for _, q := range excess {
+		q.Close()
+	}
+	return nil
+}
+
+// Closes all idle sessions held by the session pool
+func DrainSessionPool() {
+	sessions.mu.Lock()
+	idle := sessions.idle
+	sessions.idle = make(map[params][]*QzBinding)
+	sessions.prewarmed = make(map[prewarmKey]struct{})
+	sessions.mu.Unlock()
+
+	for _, list := range idle {
+		for _, q := range list {
+			q.Close()
+		}
+	}
+}
+
+// Creates and starts a new session outside the pool
+func startSession(p params) (q *QzBinding, err error) {
+	if q, err = NewQzBinding(); err != nil {
+		return nil, err
+	}
+	q.setParams(p)
+	if err = q.StartSession(); err != nil {
+		q.Close()
+		return nil, err
+	}
+	return q, nil
+}
+
+// Checks out a started session matching p from the pool or starts a new one
+func acquireSession(p params) (q *QzBinding, err error) {
+	// QATzip selects the instance of a session itself: idle sessions are shared by all placements of the
+	// requested device, the placed device is only counted in flight and bound to by Parallel*/Async workers
+	device := placeSession(p.Device)
+	defer func() {
+		if q != nil {
+			q.device = device
+		} else {
+			unplaceSession(device)
+		}
+	}()
+
+	key := p.sessionKey()
+	prewarm := 0
+
+	sessions.mu.Lock()
+	if idle := sessions.idle[key]; len(idle) > 1 {
+		q = idle[len(idle)-1]
+		sessions.idle[key] = idle[:len(idle)-1]
+	} else if len(idle) == 1 {
+		q = idle[0]
+		delete(sessions.idle, key)
+	} else if pk := newPrewarmKey(key); sessions.minIdle > 0 {
+		if _, seen := sessions.prewarmed[pk]; !seen {
+			sessions.prewarmed[pk] = struct{}{}
+			prewarm = sessions.minIdle
+		}
+	}
+	sessions.mu.Unlock()
+
+	if q != nil {
+		// session parameters match, only the buffer settings may differ
+		q.setParams(p)
+		return q, nil
+	}
+
+	if q, err = startSession(p); err != nil {
+		return nil, err
+	}
+
+	for i := 0; i < prewarm; i++ {
+		w, err := startSession(p)
+		if err != nil {
+			break
+		}
+		releaseSession(w)
+	}
+
+	return q, nil
+}
+
+// Ends the in-flight accounting of a session checked out by acquireSession
+func (q *QzBinding) unplace() {
+	if q.device != DeviceAuto {
+		unplaceSession(q.device)
+		q.device = DeviceAuto
+	}
+}
+
+// Returns a session to the pool, resetting its stream state, or closes it if it cannot be reused
+func releaseSession(q *QzBinding) (err error) {
+	if q == nil || q.closed {
+		return nil
+	}
+
+	q.collectStats()
+	q.perf = nil
+	q.unplace()
+	if err = q.resetStream(); err != nil {
+		q.Close()
+		return err
+	}
+
+	key := q.p.sessionKey()
+
+	sessions.mu.Lock()
+	if idle := sessions.idle[key]; len(idle) < sessions.maxIdle {
+		sessions.idle[key] = append(idle, q)
+		q = nil
+	}
+	sessions.mu.Unlock()
+
+	if q != nil {
+		return q.Close()
+	}
+	return nil
+}
+
+// AcquireQzBinding returns a started session from the process-wide session pool.
+// Options are applied on top of the same defaults used by Writer and Reader.
+// The session must be returned with Release when it is no longer needed.
+func AcquireQzBinding(options ...Option) (q *QzBinding, err error) {
+	p, err := bindingParams(options...)
+	if err != nil {
+		return nil, err
+	}
+	return acquireSession(p)
+}
+
+// Applies options to the defaults used by Writer and Reader
+func bindingParams(options ...Option) (p params, err error) {
+	t := new(QzBinding)
+	t.p = defaultParams()
+	if err = t.Apply(options...); err != nil {
+		return p, err
+	}
+
+	if t.p.DebugLevel == None {
+		t.p.DebugLevel = getTraceLevel()
+	}
+
+	return t.p, nil
+}
+
+// Release returns a session obtained from AcquireQzBinding to the session pool.
+// The session must not be used after it has been released.
+func (q *QzBinding) Release() error {
+	return releaseSession(q)
+}
@@ -3,10 +3,12 @@
 #include <stdio.h>
 #include <assert.h>
 #include <dlfcn.h>
+#include <pthread.h>
 #include "qatzip_internal.h"
 #include <time.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
 #ifdef ENABLE_QATGO_ZSTD
@@ -28,8 +30,29 @@ static QZSTD_isError_t QZSTD_isError = NULL;
 static QZSTD_freeCCtx_t QZSTD_freeCCtx = NULL;
 static QZSTD_freeDStream_t QZSTD_freeDStream = NULL;
 static QZSTD_getErrorName_t QZSTD_getErrorName = NULL;
-
-static int qatzip_dload_symbols(qatzip_state_t * state, void *handle, symbol_info_t * symbols, size_t num_symbols)
+static QZSTD_CCtx_reset_t QZSTD_CCtx_reset = NULL;
+static QZSTD_DCtx_reset_t QZSTD_DCtx_reset = NULL;
+static QZSTD_DCtx_setParameter_t QZSTD_DCtx_setParameter = NULL;
+static QZSTD_decompressDCtx_t QZSTD_decompressDCtx = NULL;
+static QZSTD_createCDict_t QZSTD_createCDict = NULL;
+static QZSTD_createDDict_t QZSTD_createDDict = NULL;
+static QZSTD_freeCDict_t QZSTD_freeCDict = NULL;
+static QZSTD_freeDDict_t QZSTD_freeDDict = NULL;
+static QZSTD_CCtx_refCDict_t QZSTD_CCtx_refCDict = NULL;
+static QZSTD_DCtx_refDDict_t QZSTD_DCtx_refDDict = NULL;
+static QZDICT_trainFromBuffer_t QZDICT_trainFromBuffer = NULL;
+static QZDICT_isError_t QZDICT_isError = NULL;
+
+// libraries are loaded once per process and stay loaded until exit
+static pthread_once_t zstd_load_once = PTHREAD_ONCE_INIT;
+static pthread_once_t qat_device_once = PTHREAD_ONCE_INIT;
+
+/* process-wide request counters, updated atomically */
+static qatzip_stats_t qatzip_process_stats;
+static int zstd_load_status = QZ_FAIL;
+static char zstd_load_error[256];
+
+static int qatzip_dload_symbols(void *handle, symbol_info_t * symbols, size_t num_symbols)
 {
 	if (handle == NULL || symbols == NULL)
 		return QZ_FAIL;
@@ -38,31 +61,29 @@ static int qatzip_dload_symbols(qatzip_state_t * state, void *handle, symbol_inf
 		*symbols[i].func = dlsym(handle, symbols[i].name);
 		char *error = dlerror();
 		if (error != NULL) {
-			qatzip_debug(QDL_HIGH, state, QATHDR "failed to load symbol %s: %s\n", symbols[i].name, error);
+			snprintf(zstd_load_error, sizeof(zstd_load_error), "failed to load symbol %s: %s", symbols[i].name, error);
 			return QZ_NO_SW_AVAIL;
 		}
 	}
 	return QZ_OK;
 }
 
-static int qatzip_dload_zstd_functions(qatzip_state_t * state)
+static void qatzip_dload_zstd_functions(void)
 {
-	int status = QZ_FAIL;
-
-	if (state == NULL)
-		return QZ_FAIL;
-
-	QzSession_ZSTD_T *session = &(state->zstd_session);
+	void *zstd_handle = NULL;
+	void *qzstd_handle = NULL;
 
-	session->zstd_handle = dlopen(ZSTD_LIB, RTLD_LAZY);
-	if (!session->zstd_handle) {
-		qatzip_debug(QDL_HIGH, state, QATHDR "Failed to load zstd: %s\n", dlerror());
-		return QZ_FAIL;
+	zstd_handle = dlopen(ZSTD_LIB, RTLD_LAZY);
+	if (!zstd_handle) {
+		snprintf(zstd_load_error, sizeof(zstd_load_error), "failed to load zstd: %s", dlerror());
+		zstd_load_status = QZ_FAIL;
+		return;
 	}
-	session->qzstd_handle = dlopen(QZSTD_LIB, RTLD_NOW);
-	if (!session->qzstd_handle) {
-		qatzip_debug(QDL_HIGH, state, QATHDR "failed to load qzstd: %s\n", dlerror());
-		return QZ_NO_SW_AVAIL;
+	qzstd_handle = dlopen(QZSTD_LIB, RTLD_NOW);
+	if (!qzstd_handle) {
+		snprintf(zstd_load_error, sizeof(zstd_load_error), "failed to load qzstd: %s", dlerror());
+		zstd_load_status = QZ_NO_SW_AVAIL;
+		return;
 	}
 
 	symbol_info_t qzstd_symbols[] = {
@@ -84,28 +105,46 @@ static int qatzip_dload_zstd_functions(qatzip_state_t * state)
 		{ "ZSTD_freeCCtx", (void **)&QZSTD_freeCCtx },
 		{ "ZSTD_freeDStream", (void **)&QZSTD_freeDStream },
 		{ "ZSTD_getErrorName", (void **)&QZSTD_getErrorName },
+		{ "ZSTD_CCtx_reset", (void **)&QZSTD_CCtx_reset },
+		{ "ZSTD_DCtx_reset", (void **)&QZSTD_DCtx_reset },
+		{ "ZSTD_DCtx_setParameter", (void **)&QZSTD_DCtx_setParameter },
+		{ "ZSTD_decompressDCtx", (void **)&QZSTD_decompressDCtx },
+		{ "ZSTD_createCDict", (void **)&QZSTD_createCDict },
+		{ "ZSTD_createDDict", (void **)&QZSTD_createDDict },
+		{ "ZSTD_freeCDict", (void **)&QZSTD_freeCDict },
+		{ "ZSTD_freeDDict", (void **)&QZSTD_freeDDict },
+		{ "ZSTD_CCtx_refCDict", (void **)&QZSTD_CCtx_refCDict },
+		{ "ZSTD_DCtx_refDDict", (void **)&QZSTD_DCtx_refDDict },
+		{ "ZDICT_trainFromBuffer", (void **)&QZDICT_trainFromBuffer },
+		{ "ZDICT_isError", (void **)&QZDICT_isError },
 	};
 
-	status = qatzip_dload_symbols(state, session->zstd_handle, zstd_symbols, sizeof(zstd_symbols) / sizeof(zstd_symbols[0]));
-	if (status != QZ_OK) {
-		return status;
+	zstd_load_status = qatzip_dload_symbols(zstd_handle, zstd_symbols, sizeof(zstd_symbols) / sizeof(zstd_symbols[0]));
+	if (zstd_load_status != QZ_OK) {
+		return;
 	}
 
-	status = qatzip_dload_symbols(state, session->qzstd_handle, qzstd_symbols, sizeof(qzstd_symbols) / sizeof(qzstd_symbols[0]));
-	if (status != QZ_OK) {
-		return status;
-	}
+	zstd_load_status = qatzip_dload_symbols(qzstd_handle, qzstd_symbols, sizeof(qzstd_symbols) / sizeof(qzstd_symbols[0]));
+}
 
-	return QZ_OK;
+static void qatzip_start_qat_device(void)
+{
+	QZSTD_startQatDevice();
 }
-#endif /* ENABLE_QATGO_ZSTD */
 
-void qatzip_debug(int level, qatzip_state_t * state, char *fmt, ...)
+// load zstd and the QAT sequence producer on first use (thread safe)
+static int qatzip_zstd_load(qatzip_state_t * state)
 {
-	if (!state || level > state->debug) {
-		return;
+	pthread_once(&zstd_load_once, qatzip_dload_zstd_functions);
+	if (zstd_load_status != QZ_OK) {
+		qatzip_debug(QDL_HIGH, state, QATHDR "%s\n", zstd_load_error);
 	}
+	return zstd_load_status;
+}
+#endif /* ENABLE_QATGO_ZSTD */
 
+void qatzip_debug_print(char *fmt, ...)
+{
 	va_list args;
 	va_start(args, fmt);
 	vfprintf(stderr, fmt, args);
@@ -113,17 +152,13 @@ void qatzip_debug(int level, qatzip_state_t * state, char *fmt, ...)
 }
 
 // hex dump for debug output
-static void qatzip_debug_dump(int level, qatzip_state_t * state, unsigned char *buffer, unsigned int len)
+void qatzip_debug_hexdump(unsigned char *buffer, unsigned int len)
 {
 	unsigned int pos = 0;
 
-	if (state == NULL || buffer == NULL)
+	if (buffer == NULL)
 		return;
 
-	if (state->debug < level) {
-		return;
-	}
-
 	while (pos < len) {
 		if (pos % 16 == 0)
 			fprintf(stderr, "\n%08x  ", pos);
@@ -166,7 +201,7 @@ static int qatzip_zstd_init(qatzip_state_t * state)
 		return QZ_FAIL;
 	QzSession_ZSTD_T *session = &(state->zstd_session);
 
-	ret = qatzip_dload_zstd_functions(state);
+	ret = qatzip_zstd_load(state);
 	if (ret != QZ_OK) {
 		return ret;
 	}
@@ -177,8 +212,13 @@ static int qatzip_zstd_init(qatzip_state_t * state)
 		return QZ_POST_PROCESS_ERROR;
 	}
 
-	if (session->level <= QAT_MAX_ZSTD_COMPRESSION_LEVEL) {
-		QZSTD_startQatDevice();
+	/* the QAT sequence producer does not support dictionaries, multithreading or long distance matching */
+	if (session->cdict) {
+		qatzip_debug(QDL_HIGH, state, QATHDR "warning: QAT acceleration disabled. Dictionary compression is software only\n");
+	} else if (session->nb_workers > 0 || session->long_distance) {
+		qatzip_debug(QDL_HIGH, state, QATHDR "warning: QAT acceleration disabled. Workers and long distance matching are software only\n");
+	} else if (session->level <= QAT_MAX_ZSTD_COMPRESSION_LEVEL) {
+		pthread_once(&qat_device_once, qatzip_start_qat_device);
 		session->seqProducer = QZSTD_createSeqProdState();
 		if (session->seqProducer == NULL) {
 			qatzip_debug(QDL_HIGH, state, QATHDR "error: cannot create zstd seqProducer\n");
@@ -189,16 +229,43 @@ static int qatzip_zstd_init(qatzip_state_t * state)
 		qatzip_debug(QDL_HIGH, state, QATHDR "warning: QAT acceleration disabled. Unsupported compression level %d\n", session->level);
 	}
 
-	if (QZSTD_isError(ZSTD_CCtx_setParameter(session->zstd_cctx, ZSTD_c_enableSeqProducerFallback, 1))) {
+	if (QZSTD_isError(QZSTD_CCtx_setParameter(session->zstd_cctx, ZSTD_c_enableSeqProducerFallback, 1))) {
 		qatzip_debug(QDL_HIGH, state, QATHDR "error: cannot enable sequence producer fallback\n");
 		return QZ_POST_PROCESS_ERROR;
 	}
 
-	if (QZSTD_isError(ZSTD_CCtx_setParameter(session->zstd_cctx, ZSTD_c_compressionLevel, session->level))) {
+	if (QZSTD_isError(QZSTD_CCtx_setParameter(session->zstd_cctx, ZSTD_c_compressionLevel, session->level))) {
 		qatzip_debug(QDL_HIGH, state, QATHDR "error: cannot set compression level %d\n", session->level);
 		return QZ_PARAMS;
 	}
 
+	struct {
+		ZSTD_cParameter param;
+		int value;
+		const char *name;
+	} zstd_params[] = {
+		{ ZSTD_c_nbWorkers, session->nb_workers, "nbWorkers" },
+		{ ZSTD_c_jobSize, session->job_size, "jobSize" },
+		{ ZSTD_c_enableLongDistanceMatching, session->long_distance, "enableLongDistanceMatching" },
+		{ ZSTD_c_windowLog, session->window_log, "windowLog" },
+		{ ZSTD_c_checksumFlag, session->checksum, "checksumFlag" },
+	};
+
+	/* unset parameters keep the libzstd defaults */
+	for (size_t i = 0; i < sizeof(zstd_params) / sizeof(zstd_params[0]); i++) {
+		if (zstd_params[i].value == 0)
+			continue;
+		if (QZSTD_isError(QZSTD_CCtx_setParameter(session->zstd_cctx, zstd_params[i].param, zstd_params[i].value))) {
+			qatzip_debug(QDL_HIGH, state, QATHDR "error: cannot set zstd %s %d\n", zstd_params[i].name, zstd_params[i].value);
+			return QZ_PARAMS;
+		}
+	}
+
+	if (session->cdict && QZSTD_isError(QZSTD_CCtx_refCDict(session->zstd_cctx, (ZSTD_CDict *) session->cdict))) {
+		qatzip_debug(QDL_HIGH, state, QATHDR "error: cannot reference zstd dictionary\n");
+		return QZ_PARAMS;
+	}
+
 #else /* if ZSTD library does not support sequence producer disable at compile time */
 	qatzip_debug(QDL_HIGH, state, QATHDR "error: zstd version not supported (min version is %d)\n", MIN_ZSTD_VERSION);
 	return QZ_NO_SW_AVAIL;
@@ -234,6 +301,92 @@ int qatzip_setup_session(qatzip_state_t * state)
 	return status;
 }
 
+#define QATZIP_STATS_ADD(state, field) do { \
+	(state)->stats.field++; \
+	__atomic_add_fetch(&qatzip_process_stats.field, 1, __ATOMIC_RELAXED); \
+} while (0)
+
+/*
+ * Classify a completed request as executed on a QAT device or in software.
+ * QATzip falls back silently (sw_backup), the session and thread status it reports through
+ * qzGetStatus (hw_session_stat, thd_sess_stat) and the input size threshold tell which path was taken.
+ * Without sw_backup small inputs also run on the device and a device failure fails the request.
+ */
+static void qatzip_count_request(qatzip_state_t * state, unsigned int in_size, bool compress)
+{
+	bool sw = false;
+	QzSession_T *session = &(state->session);
+	QzSessionParamsCommon_T *common = (state->algorithm == LZ4) ? &(state->lz4_params.common_params) : &(state->deflate_params.common_params);
+
+	if (state->algorithm == ZSTD) {
+		/* ZSTD decompression is software only, compression without the sequence producer as well */
+		sw = !compress || state->zstd_session.seqProducer == NULL;
+	} else if (common->sw_backup && compress && in_size < common->input_sz_thrshold) {
+		QATZIP_STATS_ADD(state, sw_small_requests);
+		QATZIP_STATS_ADD(state, sw_requests);
+		return;
+	} else if (common->sw_backup && (session->hw_session_stat != QZ_OK || session->thd_sess_stat == QZ_NO_INST_ATTACH)) {
+		sw = true;
+		QATZIP_STATS_ADD(state, sw_backoff_requests);
+		if (!state->on_sw) {
+			QATZIP_STATS_ADD(state, hw_fallbacks);
+		}
+	} else if (state->on_sw) {
+		QATZIP_STATS_ADD(state, hw_retries);
+	}
+
+	if (state->algorithm != ZSTD) {
+		state->on_sw = sw;
+	}
+	if (sw) {
+		QATZIP_STATS_ADD(state, sw_requests);
+	} else {
+		QATZIP_STATS_ADD(state, hw_requests);
+	}
+}
+
+/* Move the counters of a session into stats */
+void qatzip_take_stats(qatzip_state_t * state, qatzip_stats_t * stats)
+{
+	*stats = state->stats;
+	memset(&(state->stats), 0, sizeof(state->stats));
+}
+
+/* NUMA node of the CPU the calling thread runs on, -1 if unknown */
+int qatzip_numa_node(void)
+{
+	unsigned int cpu = 0, node = 0;
+
+	if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0) {
+		return -1;
+	}
+	return (int)node;
+}
+
+/* Pinned memory QATzip passes to the device without staging copies, on the NUMA node of the calling CPU */
+void *qatzip_malloc_pinned(size_t size)
+{
+	int node = qatzip_numa_node();
+
+	return qzMalloc(size, node < 0 ? 0 : node, PINNED_MEM);
+}
+
+void qatzip_free_pinned(void *buf)
+{
+	qzFree(buf);
+}
+
+/* Snapshot of the process-wide counters */
+void qatzip_get_stats(qatzip_stats_t * stats)
+{
+	stats->hw_requests = __atomic_load_n(&qatzip_process_stats.hw_requests, __ATOMIC_RELAXED);
+	stats->sw_requests = __atomic_load_n(&qatzip_process_stats.sw_requests, __ATOMIC_RELAXED);
+	stats->sw_small_requests = __atomic_load_n(&qatzip_process_stats.sw_small_requests, __ATOMIC_RELAXED);
+	stats->sw_backoff_requests = __atomic_load_n(&qatzip_process_stats.sw_backoff_requests, __ATOMIC_RELAXED);
+	stats->hw_fallbacks = __atomic_load_n(&qatzip_process_stats.hw_fallbacks, __ATOMIC_RELAXED);
+	stats->hw_retries = __atomic_load_n(&qatzip_process_stats.hw_retries, __ATOMIC_RELAXED);
+}
+
 qatzip_state_t *qatzip_init()
 {
 	int status = QZ_FAIL;
@@ -319,17 +472,21 @@ int qatzip_compress_crc(qatzip_state_t * state, unsigned char *in_buf, unsigned
 
 		if (last) {
 			directive = ZSTD_e_end;
+		} else if (state->flush) {
+			directive = ZSTD_e_flush;
 		} else {
 			directive = ZSTD_e_continue;
 		}
 		zstd_status = QZSTD_compressStream2(state->zstd_session.zstd_cctx, &out, &in, directive);
-		if (!ZSTD_isError(zstd_status)) {
+		if (!QZSTD_isError(zstd_status)) {
 			status = QZ_OK;
 		} else {
-			qatzip_debug(QDL_HIGH, state, QATHDR "error: %s\n", ZSTD_getErrorName(zstd_status));
+			qatzip_debug(QDL_HIGH, state, QATHDR "error: %s\n", QZSTD_getErrorName(zstd_status));
 		}
 		stream->in_sz = in.pos;
 		stream->out_sz = out.pos;
+		/* ZSTD_e_end and ZSTD_e_flush return the number of bytes still to be flushed (multithreaded or full output) */
+		stream->pending_out = (directive != ZSTD_e_continue && status == QZ_OK && zstd_status > 0) ? 1 : 0;
 		qatzip_debug(QDL_HIGH, state, QATHDR "compress state: (e) i:%u o:%u pi:%u po:%u ret: %d\n", stream->in_sz, stream->out_sz,
 			     stream->pending_in, stream->pending_out, status);
 #endif /* ENABLE_QATGO_ZSTD */
@@ -357,12 +514,187 @@ fail:
 		return status;
 	}
 
+	if (in_size > 0) {
+		qatzip_count_request(state, in_size, true);
+	}
+
 	stream->in = NULL;
 	stream->out = NULL;
 
 	return status;
 }
 
+/*
+ * Compress count inputs, each into a complete member/frame, in a single call.
+ * Inputs are packed back to back in in_buf with sizes in_sizes, outputs are written back to back
+ * in out_buf with capacities out_sizes, which are updated to the produced sizes.
+ * crcs and statuses receive the CRC (DEFLATE only) and status of each input.
+ */
+int qatzip_compress_batch(qatzip_state_t * state, unsigned char *in_buf, unsigned int *in_sizes,
+			  unsigned char *out_buf, unsigned int *out_sizes, unsigned long *crcs, int *statuses, unsigned int count)
+{
+	int status = QZ_OK;
+	int saved_last = 0;
+	unsigned int i = 0;
+
+	if (!state || !state->session_active) {
+		qatzip_debug(QDL_HIGH, state, QATHDR "error: QAT session for state %p is not active\n", state);
+		return QZ_FAIL;
+	}
+
+	saved_last = state->last;
+	state->last = 1;
+
+	qatzip_debug(QDL_HIGH, state, QATHDR "compress batch: count:%u\n", count);
+
+	for (i = 0; i < count; i++) {
+		unsigned int consumed = 0;
+		unsigned int produced = 0;
+		unsigned int out_size = out_sizes[i];
+
+		crcs[i] = 0;
+		statuses[i] = QZ_OK;
+
+		while (consumed < in_sizes[i]) {
+			statuses[i] = qatzip_compress_crc(state, in_buf + consumed, in_sizes[i] - consumed,
+							  out_buf + produced, out_size - produced, &crcs[i]);
+			if (statuses[i] != QZ_OK) {
+				break;
+			}
+			if (state->stream.in_sz == 0) {
+				/* no progress, output capacity is exhausted */
+				statuses[i] = QZ_BUF_ERROR;
+				break;
+			}
+			consumed += state->stream.in_sz;
+			produced += state->stream.out_sz;
+		}
+
+		if (statuses[i] != QZ_OK) {
+			qatzip_reset_stream(state);
+			state->last = 1;
+			status = statuses[i];
+		}
+
+		in_buf += in_sizes[i];
+		out_buf += out_size;
+		out_sizes[i] = produced;
+	}
+
+	state->last = saved_last;
+
+	return status;
+}
+
+#ifdef ENABLE_QATGO_ZSTD
+/* create the decompression context on first use */
+static int qatzip_zstd_dctx(qatzip_state_t * state)
+{
+	if (state->zstd_session.zstd_dctx != NULL) {
+		return QZ_OK;
+	}
+
+	state->zstd_session.zstd_dctx = QZSTD_createDStream();
+	if (state->zstd_session.zstd_dctx == NULL) {
+		qatzip_debug(QDL_HIGH, state, QATHDR "error: cannot create zstd decompression context\n");
+		return QZ_FAIL;
+	}
+	if (state->zstd_session.window_log
+	    && QZSTD_isError(QZSTD_DCtx_setParameter(state->zstd_session.zstd_dctx, ZSTD_d_windowLogMax, state->zstd_session.window_log))) {
+		qatzip_debug(QDL_HIGH, state, QATHDR "error: cannot set zstd windowLogMax %d\n", state->zstd_session.window_log);
+		return QZ_PARAMS;
+	}
+	if (state->zstd_session.ddict
+	    && QZSTD_isError(QZSTD_DCtx_refDDict(state->zstd_session.zstd_dctx, (ZSTD_DDict *) state->zstd_session.ddict))) {
+		qatzip_debug(QDL_HIGH, state, QATHDR "error: cannot reference zstd dictionary\n");
+		return QZ_PARAMS;
+	}
+	return QZ_OK;
+}
+
+static int qatzip_zstd_decompress(qatzip_state_t * state, QzStream_T * stream)
+{
+	int status = QZ_FAIL;
+	size_t zstd_status = 0;
+	ZSTD_inBuffer in;
+	ZSTD_outBuffer out;
+	in.src = (const void *)stream->in;
+	in.pos = 0;
+	in.size = stream->in_sz;
+	out.dst = (void *)stream->out;
+	out.pos = 0;
+	out.size = stream->out_sz;
+
+	status = qatzip_zstd_dctx(state);
+	if (status != QZ_OK) {
+		return status;
+	}
+
+	zstd_status = QZSTD_decompressStream(state->zstd_session.zstd_dctx, &out, &in);
+	if (!QZSTD_isError(zstd_status)) {
+		status = QZ_OK;
+		/* 0 means a frame was completely decoded and flushed, a call without progress leaves the frame state as is */
+		if (in.pos > 0 || out.pos > 0) {
+			state->zstd_session.in_frame = (zstd_status != 0);
+		}
+	} else {
+		status = QZ_FAIL;
+		qatzip_debug(QDL_HIGH, state, QATHDR "error: %s\n", QZSTD_getErrorName(zstd_status));
+	}
+	stream->in_sz = in.pos;
+	stream->out_sz = out.pos;
+	/* a full output buffer means the decoder may still hold data to flush */
+	stream->pending_out = (out.pos == out.size) ? 1 : 0;
+
+	return status;
+}
+#endif /* ENABLE_QATGO_ZSTD */
+
+/*
+ * Decompress complete ZSTD frames whose total content size fits in out_buf in a single call (ZSTD_decompressDCtx),
+ * bypassing the streaming decoder. Must only be used between frames of a stream.
+ */
+int qatzip_zstd_decompress_frames(qatzip_state_t * state, unsigned char *in_buf, unsigned int in_size, unsigned char *out_buf,
+				  unsigned int out_size)
+{
+#ifdef ENABLE_QATGO_ZSTD
+	int status = QZ_FAIL;
+	size_t zstd_status = 0;
+
+	if (!state || !state->session_active || state->algorithm != ZSTD) {
+		qatzip_debug(QDL_HIGH, state, QATHDR "error: zstd session for state %p is not active\n", state);
+		return QZ_FAIL;
+	}
+
+	QzStream_T *stream = &(state->stream);
+	stream->in_sz = 0;
+	stream->out_sz = 0;
+
+	status = qatzip_zstd_dctx(state);
+	if (status != QZ_OK) {
+		return status;
+	}
+
+	qatzip_debug(QDL_HIGH, state, QATHDR "decompress frames: (s) i:%u o:%u\n", in_size, out_size);
+
+	zstd_status = QZSTD_decompressDCtx(state->zstd_session.zstd_dctx, out_buf, out_size, in_buf, in_size);
+	if (QZSTD_isError(zstd_status)) {
+		qatzip_debug(QDL_HIGH, state, QATHDR "error: %s\n", QZSTD_getErrorName(zstd_status));
+		return QZ_DATA_ERROR;
+	}
+	stream->in_sz = in_size;
+	stream->out_sz = zstd_status;
+	qatzip_count_request(state, in_size, false);
+
+	qatzip_debug(QDL_HIGH, state, QATHDR "decompress frames: (e) i:%u o:%u\n", stream->in_sz, stream->out_sz);
+	qatzip_debug_dump(QDL_DEBUG, state, out_buf, stream->out_sz);
+
+	return QZ_OK;
+#else
+	return QZ_NO_SW_AVAIL;
+#endif /* ENABLE_QATGO_ZSTD */
+}
+
 int qatzip_decompress(qatzip_state_t * state, unsigned char *in_buf, unsigned int in_size, unsigned char *out_buf, unsigned int out_size)
 {
 	int status = QZ_FAIL;
@@ -385,28 +717,7 @@ int qatzip_decompress(qatzip_state_t * state, unsigned char *in_buf, unsigned in
 
 	if (state->algorithm == ZSTD) {
 #ifdef ENABLE_QATGO_ZSTD
-		size_t zstd_status = 0;
-		ZSTD_inBuffer in;
-		ZSTD_outBuffer out;
-		in.src = (const void *)in_buf;
-		in.pos = 0;
-		in.size = in_size;
-		out.dst = (void *)out_buf;
-		out.pos = 0;
-		out.size = out_size;
-
-		if (state->zstd_session.zstd_dctx == NULL) {
-			state->zstd_session.zstd_dctx = QZSTD_createDStream();
-		}
-
-		zstd_status = QZSTD_decompressStream(state->zstd_session.zstd_dctx, &out, &in);
-		if (!ZSTD_isError(zstd_status)) {
-			status = QZ_OK;
-		} else {
-			qatzip_debug(QDL_HIGH, state, QATHDR "error: %s\n", QZSTD_getErrorName(zstd_status));
-		}
-		stream->in_sz = in.pos;
-		stream->out_sz = out.pos;
+		status = qatzip_zstd_decompress(state, stream);
 #endif /* ENABLE_QATGO_ZSTD */
 	} else {
 		status = qzDecompress(session, stream->in, &(stream->in_sz), stream->out, &(stream->out_sz));
@@ -421,12 +732,94 @@ int qatzip_decompress(qatzip_state_t * state, unsigned char *in_buf, unsigned in
 		return status;
 	}
 
+	qatzip_count_request(state, in_size, false);
+
+	stream->in = NULL;
+	stream->out = NULL;
+
+	return status;
+}
+
+int qatzip_decompress_stream(qatzip_state_t * state, unsigned char *in_buf, unsigned int in_size, unsigned char *out_buf,
+			     unsigned int out_size)
+{
+	int status = QZ_FAIL;
+	if (!state || !state->session_active) {
+		qatzip_debug(QDL_HIGH, state, QATHDR "error: QAT session for state %p is not active\n", state);
+		return QZ_FAIL;
+	}
+
+	QzSession_T *session = &(state->session);
+	QzStream_T *stream = &(state->stream);
+
+	stream->in = in_buf;
+	stream->out = out_buf;
+	stream->in_sz = in_size;
+	stream->out_sz = out_size;
+
+	qatzip_debug(QDL_HIGH, state, QATHDR "decompress stream: (s) i:%u o:%u pi:%u po:%u last:%d\n", stream->in_sz, stream->out_sz,
+		     stream->pending_in, stream->pending_out, state->last);
+	qatzip_debug_dump(QDL_DEBUG, state, stream->in, stream->in_sz);
+
+	if (state->algorithm == ZSTD) {
+#ifdef ENABLE_QATGO_ZSTD
+		status = qatzip_zstd_decompress(state, stream);
+#endif /* ENABLE_QATGO_ZSTD */
+	} else {
+		state->stream_active = true;
+		status = qzDecompressStream(session, stream, state->last);
+	}
+	qatzip_debug(QDL_HIGH, state, QATHDR "decompress stream: (e) i:%u o:%u pi:%u po:%u ret: %d\n", stream->in_sz, stream->out_sz,
+		     stream->pending_in, stream->pending_out, status);
+	qatzip_debug_dump(QDL_DEBUG, state, stream->out, stream->out_sz);
+
+	if (status != QZ_OK) {
+		qatzip_debug(QDL_HIGH, state, QATHDR "error: decompressing input stream (status: %d)\n", status);
+	} else if (stream->in_sz > 0 || stream->out_sz > 0) {
+		qatzip_count_request(state, in_size, false);
+	}
+
 	stream->in = NULL;
 	stream->out = NULL;
 
 	return status;
 }
 
+int qatzip_reset_stream(qatzip_state_t * state)
+{
+	if (!state || !state->session_active) {
+		return QZ_FAIL;
+	}
+
+	qatzip_debug(QDL_HIGH, state, QATHDR "resetting stream...\n");
+
+	if (state->stream_active) {
+		qzEndStream(&(state->session), &(state->stream));
+		state->stream_active = false;
+	}
+
+#ifdef ENABLE_QATGO_ZSTD
+	/* keep contexts, parameters and the registered sequence producer, drop only the frame in progress */
+	if (state->algorithm == ZSTD) {
+		if (state->zstd_session.zstd_cctx && QZSTD_isError(QZSTD_CCtx_reset(state->zstd_session.zstd_cctx, ZSTD_reset_session_only))) {
+			qatzip_debug(QDL_HIGH, state, QATHDR "error: cannot reset zstd compression context\n");
+			return QZ_FAIL;
+		}
+		if (state->zstd_session.zstd_dctx && QZSTD_isError(QZSTD_DCtx_reset(state->zstd_session.zstd_dctx, ZSTD_reset_session_only))) {
+			qatzip_debug(QDL_HIGH, state, QATHDR "error: cannot reset zstd decompression context\n");
+			return QZ_FAIL;
+		}
+	}
+#endif /* ENABLE_QATGO_ZSTD */
+
+	memset(&(state->stream), 0, sizeof(state->stream));
+	state->last = 0;
+	state->flush = 0;
+	state->zstd_session.in_frame = 0;
+
+	return QZ_OK;
+}
+
 int qatzip_close(qatzip_state_t * state)
 {
 	int status = QZ_FAIL;
@@ -439,6 +832,12 @@ int qatzip_close(qatzip_state_t * state)
 	if (!(state->session_active)) {
 		goto done;
 	}
+
+	if (state->stream_active) {
+		qzEndStream(&(state->session), &(state->stream));
+		state->stream_active = false;
+	}
+
 	status = qzTeardownSession(&(state->session));
 	if (status != QZ_OK) {
 		goto done;
@@ -457,10 +856,6 @@ int qatzip_close(qatzip_state_t * state)
 			QZSTD_freeCCtx(state->zstd_session.zstd_cctx);
 		if (state->zstd_session.zstd_dctx)
 			QZSTD_freeDStream(state->zstd_session.zstd_dctx);
-		if (state->zstd_session.qzstd_handle)
-			dlclose(state->zstd_session.qzstd_handle);
-		if (state->zstd_session.zstd_handle)
-			dlclose(state->zstd_session.zstd_handle);
 	}
 #endif /* ENABLE_QATGO_ZSTD */
 	state->session_active = false;
@@ -471,3 +866,61 @@ done:
 	free(state);
 	return status;
 }
+
+/* Prepared dictionaries are shared by all sessions that use them and are freed by their owner */
+void *qatzip_zstd_create_cdict(const void *dict, size_t dict_size, int level)
+{
+#ifdef ENABLE_QATGO_ZSTD
+	if (qatzip_zstd_load(NULL) != QZ_OK) {
+		return NULL;
+	}
+	return QZSTD_createCDict(dict, dict_size, level);
+#else
+	return NULL;
+#endif /* ENABLE_QATGO_ZSTD */
+}
+
+void *qatzip_zstd_create_ddict(const void *dict, size_t dict_size)
+{
+#ifdef ENABLE_QATGO_ZSTD
+	if (qatzip_zstd_load(NULL) != QZ_OK) {
+		return NULL;
+	}
+	return QZSTD_createDDict(dict, dict_size);
+#else
+	return NULL;
+#endif /* ENABLE_QATGO_ZSTD */
+}
+
+void qatzip_zstd_free_dicts(void *cdict, void *ddict)
+{
+#ifdef ENABLE_QATGO_ZSTD
+	if (qatzip_zstd_load(NULL) != QZ_OK) {
+		return;
+	}
+	if (cdict)
+		QZSTD_freeCDict((ZSTD_CDict *) cdict);
+	if (ddict)
+		QZSTD_freeDDict((ZSTD_DDict *) ddict);
+#endif /* ENABLE_QATGO_ZSTD */
+}
+
+/* Train a dictionary of at most *dict_size bytes from samples packed back to back, *dict_size is set to its length */
+int qatzip_zstd_train_dict(void *dict, size_t *dict_size, const void *samples, const size_t *sample_sizes, unsigned count)
+{
+#ifdef ENABLE_QATGO_ZSTD
+	int status = qatzip_zstd_load(NULL);
+	if (status != QZ_OK) {
+		return status;
+	}
+
+	size_t ret = QZDICT_trainFromBuffer(dict, *dict_size, samples, sample_sizes, count);
+	if (QZDICT_isError(ret)) {
+		return QZ_FAIL;
+	}
+	*dict_size = ret;
+	return QZ_OK;
+#else
+	return QZ_NO_SW_AVAIL;
+#endif /* ENABLE_QATGO_ZSTD */
+}
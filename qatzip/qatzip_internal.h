@@ -39,14 +39,26 @@ typedef void (*QZSTD_freeSeqProdState_t)(void *);
 typedef ZSTD_CCtx *(*QZSTD_createCCtx_t)();
 typedef ZSTD_DStream *(*QZSTD_createDStream_t)();
 typedef void (*QZSTD_registerSequenceProducer_t)(ZSTD_CCtx *, void *, void *);
-typedef int (*QZSTD_CCtx_setParameter_t)(ZSTD_CCtx *, int, int);
+typedef size_t (*QZSTD_CCtx_setParameter_t)(ZSTD_CCtx *, int, int);
 typedef size_t (*QZSTD_compressStream2_t)(ZSTD_CCtx *, ZSTD_outBuffer *, ZSTD_inBuffer *, ZSTD_EndDirective);
 typedef size_t (*QZSTD_decompressStream_t)(ZSTD_DStream *, ZSTD_outBuffer *, ZSTD_inBuffer *);
 typedef size_t (*QZSTD_compressBound_t)(size_t);
-typedef size_t (*QZSTD_isError_t)(size_t);
+typedef unsigned (*QZSTD_isError_t)(size_t);
 typedef size_t (*QZSTD_freeCCtx_t)(ZSTD_CCtx *);
 typedef size_t (*QZSTD_freeDStream_t)(ZSTD_DStream *);
 typedef const char *(*QZSTD_getErrorName_t)(size_t);
+typedef size_t (*QZSTD_CCtx_reset_t)(ZSTD_CCtx *, ZSTD_ResetDirective);
+typedef size_t (*QZSTD_DCtx_reset_t)(ZSTD_DCtx *, ZSTD_ResetDirective);
+typedef size_t (*QZSTD_DCtx_setParameter_t)(ZSTD_DCtx *, int, int);
+typedef size_t (*QZSTD_decompressDCtx_t)(ZSTD_DCtx *, void *, size_t, const void *, size_t);
+typedef ZSTD_CDict *(*QZSTD_createCDict_t)(const void *, size_t, int);
+typedef ZSTD_DDict *(*QZSTD_createDDict_t)(const void *, size_t);
+typedef size_t (*QZSTD_freeCDict_t)(ZSTD_CDict *);
+typedef size_t (*QZSTD_freeDDict_t)(ZSTD_DDict *);
+typedef size_t (*QZSTD_CCtx_refCDict_t)(ZSTD_CCtx *, const ZSTD_CDict *);
+typedef size_t (*QZSTD_DCtx_refDDict_t)(ZSTD_DCtx *, const ZSTD_DDict *);
+typedef size_t (*QZDICT_trainFromBuffer_t)(void *, size_t, const void *, const size_t *, unsigned);
+typedef unsigned (*QZDICT_isError_t)(size_t);
 
 #endif /* ZSTD_VERSION_NUMBER >= MIN_ZSTD_VERSION */
 
@@ -56,11 +68,27 @@ typedef struct {
 	ZSTD_DStream *zstd_dctx;
 #endif				/* ENABLE_QATGO_ZSTD */
 	void *seqProducer;
-	void *zstd_handle;
-	void *qzstd_handle;
+	void *cdict;		/* shared ZSTD_CDict, owned by the Go ZstdDictionary */
+	void *ddict;		/* shared ZSTD_DDict, owned by the Go ZstdDictionary */
 	int level;
+	int nb_workers;		/* ZSTD_c_nbWorkers */
+	int job_size;		/* ZSTD_c_jobSize */
+	int long_distance;	/* ZSTD_c_enableLongDistanceMatching */
+	int window_log;		/* ZSTD_c_windowLog and ZSTD_d_windowLogMax */
+	int checksum;		/* ZSTD_c_checksumFlag */
+	int in_frame;		/* the decoder is inside a frame */
 } QzSession_ZSTD_T;
 
+/* Requests executed on a QAT device or in software, see qatzip_count_request */
+typedef struct {
+	unsigned long hw_requests;	/* executed on a QAT device (ZSTD: QAT sequence producer registered) */
+	unsigned long sw_requests;	/* executed in software */
+	unsigned long sw_small_requests;	/* in software as the input is below input_sz_thrshold */
+	unsigned long sw_backoff_requests;	/* in software while no instance is attached, waiting wait_cnt_thrshold calls before retrying */
+	unsigned long hw_fallbacks;	/* the session lost its device and continued in software */
+	unsigned long hw_retries;	/* the session attached a device again after falling back */
+} qatzip_stats_t;
+
 typedef struct {
 	QzSession_T session;
 	QzSessionParamsDeflate_T deflate_params;
@@ -69,7 +97,11 @@ typedef struct {
 	QzStream_T stream;
 	int algorithm;
 	int last;
+	int flush;		/* ZSTD: flush buffered data without ending the frame */
+	int on_sw;		/* the previous request fell back to software */
+	qatzip_stats_t stats;	/* since the last qatzip_take_stats */
 	bool session_active;
+	bool stream_active;
 	int debug;
 	int status;
 
@@ -82,9 +114,43 @@ int qatzip_setup_session(qatzip_state_t * state);
 int qatzip_compress(qatzip_state_t * state, unsigned char *in_buf, unsigned int in_size, unsigned char *out_buf, unsigned int out_size);
 int qatzip_compress_crc(qatzip_state_t * state, unsigned char *in_buf,
 			unsigned int in_size, unsigned char *out_buf, unsigned int out_size, unsigned long *crc);
+int qatzip_compress_batch(qatzip_state_t * state, unsigned char *in_buf, unsigned int *in_sizes,
+			  unsigned char *out_buf, unsigned int *out_sizes, unsigned long *crcs, int *statuses, unsigned int count);
 int qatzip_decompress(qatzip_state_t * state, unsigned char *in_buf, unsigned int in_size, unsigned char *out_buf, unsigned int out_size);
+int qatzip_decompress_stream(qatzip_state_t * state, unsigned char *in_buf, unsigned int in_size, unsigned char *out_buf,
+			     unsigned int out_size);
+int qatzip_zstd_decompress_frames(qatzip_state_t * state, unsigned char *in_buf, unsigned int in_size, unsigned char *out_buf,
+				  unsigned int out_size);
+int qatzip_reset_stream(qatzip_state_t * state);
 int qatzip_close(qatzip_state_t * state);
-void qatzip_debug(int level, qatzip_state_t * state, char *fmt, ...);
+void *qatzip_zstd_create_cdict(const void *dict, size_t dict_size, int level);
+void *qatzip_zstd_create_ddict(const void *dict, size_t dict_size);
+void qatzip_zstd_free_dicts(void *cdict, void *ddict);
+int qatzip_zstd_train_dict(void *dict, size_t *dict_size, const void *samples, const size_t *sample_sizes, unsigned count);
+void qatzip_take_stats(qatzip_state_t * state, qatzip_stats_t * stats);
+void qatzip_get_stats(qatzip_stats_t * stats);
+int qatzip_numa_node(void);
+void *qatzip_malloc_pinned(size_t size);
+void qatzip_free_pinned(void *buf);
+void qatzip_debug_print(char *fmt, ...);
+void qatzip_debug_hexdump(unsigned char *buffer, unsigned int len);
+
+/* debug output, the arguments are only evaluated when the level is enabled (compiled out with QATGO_NO_DEBUG) */
+#ifdef QATGO_NO_DEBUG
+#define qatzip_debug(level, state, ...) do { (void)(state); } while (0)
+#define qatzip_debug_dump(level, state, buffer, len) do { (void)(state); } while (0)
+#else
+#define qatzip_debug(level, state, ...) \
+	do { \
+		if (__builtin_expect((state) != NULL && (level) <= (state)->debug, 0)) \
+			qatzip_debug_print(__VA_ARGS__); \
+	} while (0)
+#define qatzip_debug_dump(level, state, buffer, len) \
+	do { \
+		if (__builtin_expect((state) != NULL && (level) <= (state)->debug, 0)) \
+			qatzip_debug_hexdump(buffer, len); \
+	} while (0)
+#endif
 
 #define QATHDR "QATzip (internal): "
 /* Debug Levels */
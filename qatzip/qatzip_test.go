@@ -6,8 +6,20 @@ import (
 	"bytes"
 	"compress/flate"
 	"compress/gzip"
+	"context"
+	"encoding/json"
+	"errors"
+	"expvar"
+	"fmt"
+	"hash/crc32"
 	"io"
+	"math/rand"
+	"os"
+	"path/filepath"
+	"sync"
+	"sync/atomic"
 	"testing"
+	"time"
 
 	"github.com/DataDog/zstd"
 	"github.com/pierrec/lz4/v4"
@@ -510,3 +522,1629 @@ func TestWriterApply(t *testing.T) {
 	}
 	z.Close()
 }
+
+// randomString returns a reproducible, poorly compressible string of length n
+func randomString(n int, seed int64) string {
+	const alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 \n"
+	r := rand.New(rand.NewSource(seed))
+	b := make([]byte, n)
+	for i := range b {
+		b[i] = alphabet[r.Intn(len(alphabet))]
+	}
+	return string(b)
+}
+
+// countingReader records how much compressed input has been handed out
+type countingReader struct {
+	r io.Reader
+	n int
+}
+
+func (c *countingReader) Read(p []byte) (int, error) {
+	n, err := c.r.Read(p)
+	c.n += n
+	return n, err
+}
+
+func TestDecompressStreamBoundedInput(t *testing.T) {
+	str := randomString(4*1024*1024, 1)
+
+	b := new(bytes.Buffer)
+	g := gzip.NewWriter(b)
+	g.Write([]byte(str))
+	if err := g.Close(); err != nil {
+		t.Fatalf("TestInit: error failed to close compress/gzip: '%v'", err)
+	}
+	compressedLen := b.Len()
+
+	cr := &countingReader{r: b}
+	z, err := NewReader(cr)
+	if err != nil {
+		t.Fatalf("TestInit: error failed to initialize QATgo: '%v'", err)
+	}
+
+	if err = z.Apply(InputBufLengthOption(MinBufferLength), OutputBufLengthOption(MinBufferLength)); err != nil {
+		t.Fatalf("TestInit: error failed to apply parameters '%v'", err)
+	}
+
+	first := make([]byte, 1024)
+	if _, err = io.ReadFull(z, first); err != nil {
+		t.Fatalf("TestFail: error reading first block err:'%v'", err)
+	}
+
+	if cr.n >= compressedLen {
+		t.Errorf("TestFail: expected output before end of input, but %d of %d bytes were read", cr.n, compressedLen)
+	}
+
+	if len(z.inputBuf) != MinBufferLength {
+		t.Errorf("TestFail: input window grew to %d bytes", len(z.inputBuf))
+	}
+
+	rest := new(bytes.Buffer)
+	if _, err = io.Copy(rest, z); err != nil {
+		t.Fatalf("TestFail: error decompressing stream err:'%v'", err)
+	}
+
+	if string(first)+rest.String() != str {
+		t.Errorf("TestFail: decompressed stream does not match input")
+	}
+}
+
+func TestSessionPoolReuse(t *testing.T) {
+	if err := SetSessionPoolSize(0, 2); err != nil {
+		t.Fatalf("TestInit: error failed to size session pool err:'%v'", err)
+	}
+	defer SetSessionPoolSize(DefaultSessionPoolMinIdle, DefaultSessionPoolMaxIdle)
+	DrainSessionPool()
+
+	b := new(bytes.Buffer)
+	z := NewWriter(b)
+	if err := z.Reset(b); err != nil {
+		t.Fatalf("TestInit: error failed to reset Writer err:'%v'", err)
+	}
+	state := z.q.state
+
+	for i := 0; i < resetCount; i++ {
+		b.Reset()
+		if _, err := z.Write([]byte(strGettysBurgAddress)); err != nil {
+			t.Fatalf("TestFail: error writing to Writer err:'%v'", err)
+		}
+		if err := z.Close(); err != nil {
+			t.Fatalf("TestFail: error closing Writer err:'%v'", err)
+		}
+		if _, err := z.Write([]byte(strGettysBurgAddress)); err != ErrWriterClosed {
+			t.Fatalf("TestFail: expected closed writer error, but received '%v'", err)
+		}
+
+		g, err := gzip.NewReader(b)
+		if err != nil {
+			t.Fatalf("TestFail: error failed to initialize compress/gzip '%v'", err)
+		}
+		runStringCompare(strGettysBurgAddress, g, t)
+
+		if err := z.Reset(b); err != nil {
+			t.Fatalf("TestFail: error failed to reset Writer err:'%v'", err)
+		}
+		if z.q.state != state {
+			t.Fatalf("TestFail: expected pooled session to be reused after Reset")
+		}
+	}
+	z.Close()
+
+	q1, err := AcquireQzBinding(DirOption(Compress))
+	if err != nil {
+		t.Fatalf("TestFail: error acquiring pooled session err:'%v'", err)
+	}
+	q2, err := AcquireQzBinding(DirOption(Compress))
+	if err != nil {
+		t.Fatalf("TestFail: error acquiring pooled session err:'%v'", err)
+	}
+	if q1 == q2 {
+		t.Errorf("TestFail: session handed out twice")
+	}
+	sessions.mu.Lock()
+	_, kept := sessions.idle[q1.p.sessionKey()]
+	sessions.mu.Unlock()
+	if kept {
+		t.Errorf("TestFail: session pool kept a key without idle sessions")
+	}
+	q1.Release()
+	q2.Release()
+}
+
+func TestConcurrentSessionsZSTD(t *testing.T) {
+	const workers = 8
+	errs := make(chan error, workers)
+
+	for i := 0; i < workers; i++ {
+		go func() {
+			b := new(bytes.Buffer)
+			z := NewWriter(b)
+			z.Apply(AlgorithmOption(ZSTD))
+			if _, err := z.Write([]byte(strGettysBurgAddress)); err != nil {
+				errs <- err
+				return
+			}
+			errs <- z.Close()
+		}()
+	}
+
+	for i := 0; i < workers; i++ {
+		err := <-errs
+		if err == ErrUnsupportedFmt || err == ErrNoSwAvail {
+			t.Skip("Zstd acceleration is not supported by current driver or zstd library version, skipping this test...")
+		}
+		if err != nil {
+			t.Errorf("TestFail: error compressing concurrently err:'%v'", err)
+		}
+	}
+}
+
+func TestWriterResetZSTD(t *testing.T) {
+	b := new(bytes.Buffer)
+	z := NewWriter(b)
+	z.Apply(AlgorithmOption(ZSTD))
+
+	var state any
+	for i := 0; i < 4; i++ {
+		b.Reset()
+		_, err := z.Write([]byte(strGettysBurgAddress))
+		if err == ErrUnsupportedFmt || err == ErrNoSwAvail {
+			t.Skip("Zstd acceleration is not supported by current driver or zstd library version, skipping this test...")
+		}
+		if err != nil {
+			t.Fatalf("TestFail: error writing zstd stream err:'%v'", err)
+		}
+		if state != nil && any(z.q.state) != state {
+			t.Errorf("TestFail: expected zstd session to be reused after Reset")
+		}
+		state = z.q.state
+
+		if err = z.Close(); err != nil {
+			t.Fatalf("TestFail: error closing Writer err:'%v'", err)
+		}
+
+		d, err := zstd.Decompress(nil, b.Bytes())
+		if err != nil {
+			t.Fatalf("TestFail: decompression error after %d resets: %v", i, err)
+		}
+		if string(d) != strGettysBurgAddress {
+			t.Fatalf("TestFail: decompressed data mismatch after %d resets", i)
+		}
+
+		if err = z.Reset(b); err != nil {
+			t.Fatalf("TestFail: error resetting Writer err:'%v'", err)
+		}
+	}
+	z.Close()
+}
+
+// failingWriter accepts n bytes and then fails
+type failingWriter struct {
+	n int
+}
+
+var errFailingWriter = errors.New("failingWriter: write failed")
+
+func (f *failingWriter) Write(p []byte) (int, error) {
+	if len(p) > f.n {
+		return 0, errFailingWriter
+	}
+	f.n -= len(p)
+	return len(p), nil
+}
+
+func TestPipelinedWriter(t *testing.T) {
+	str := randomString(4*1024*1024, 2)
+	b := new(bytes.Buffer)
+
+	z := NewWriter(b)
+	err := z.Apply(PipelineDepthOption(4), OutputBufLengthOption(MinBufferLength))
+	if err != nil {
+		t.Fatalf("TestInit: error failed to apply parameters '%v'", err)
+	}
+
+	for i := 0; i < len(str); i += 64 * 1024 {
+		if _, err = z.Write([]byte(str[i : i+64*1024])); err != nil {
+			t.Fatalf("TestFail: error writing to pipelined Writer err:'%v'", err)
+		}
+	}
+	if err = z.Close(); err != nil {
+		t.Fatalf("TestFail: error closing pipelined Writer err:'%v'", err)
+	}
+
+	g, err := gzip.NewReader(b)
+	if err != nil {
+		t.Fatalf("TestFail: error failed to initialize compress/gzip '%v'", err)
+	}
+	runStringCompare(str, g, t)
+
+	// downstream errors are reported by Write or Close
+	z = NewWriter(&failingWriter{n: 1024})
+	z.Apply(PipelineDepthOption(2), OutputBufLengthOption(MinBufferLength))
+	for i := 0; i < len(str) && err == nil; i += 64 * 1024 {
+		_, err = z.Write([]byte(str[i : i+64*1024]))
+	}
+	if err == nil {
+		err = z.Close()
+	}
+	if err != errFailingWriter {
+		t.Errorf("TestFail: expected downstream write error, but received '%v'", err)
+	}
+}
+
+func TestParallelWriter(t *testing.T) {
+	str := randomString(5*MinBlockSize+1234, 3)
+
+	for _, alg := range []Algorithm{DEFLATE, ZSTD} {
+		b := new(bytes.Buffer)
+		z := NewParallelWriter(b)
+		err := z.Apply(AlgorithmOption(alg), BlockSizeOption(MinBlockSize), WorkersOption(3))
+		if err != nil {
+			t.Fatalf("TestInit: error failed to apply parameters '%v'", err)
+		}
+
+		for i := 0; i < len(str); i += 10000 {
+			j := i + 10000
+			if j > len(str) {
+				j = len(str)
+			}
+			if _, err = z.Write([]byte(str[i:j])); err != nil {
+				t.Fatalf("TestFail: error writing to ParallelWriter err:'%v'", err)
+			}
+		}
+		if err = z.Close(); err != nil {
+			t.Fatalf("TestFail: error closing ParallelWriter err:'%v'", err)
+		}
+
+		if crc := crc32.ChecksumIEEE([]byte(str)); z.CRC32() != crc {
+			t.Errorf("TestFail: combined CRC %08x does not match %08x", z.CRC32(), crc)
+		}
+		if perf := z.GetPerf(); perf.BytesIn != uint64(len(str)) || perf.BytesOut != uint64(b.Len()) {
+			t.Errorf("TestFail: perf counters in:%v out:%v, expected in:%v out:%v", perf.BytesIn, perf.BytesOut, len(str), b.Len())
+		}
+
+		if alg == DEFLATE {
+			g, err := gzip.NewReader(b)
+			if err != nil {
+				t.Fatalf("TestFail: error failed to initialize compress/gzip '%v'", err)
+			}
+			runStringCompare(str, g, t)
+		} else {
+			g := zstd.NewReader(b)
+			runStringCompare(str, g, t)
+			g.Close()
+		}
+	}
+
+	// raw DEFLATE blocks cannot be concatenated
+	z := NewParallelWriter(io.Discard)
+	z.Apply(DeflateFmtOption(DeflateRaw))
+	if _, err := z.Write([]byte(str)); err != ErrParamParallelFmt {
+		t.Errorf("TestFail: expected '%v', but received '%v'", ErrParamParallelFmt, err)
+	}
+}
+
+func TestParallelReader(t *testing.T) {
+	str := randomString(7*MinBlockSize+4321, 4)
+
+	for _, alg := range []Algorithm{DEFLATE, ZSTD} {
+		b := new(bytes.Buffer)
+		w := NewParallelWriter(b)
+		w.Apply(AlgorithmOption(alg), BlockSizeOption(MinBlockSize))
+		if _, err := w.Write([]byte(str)); err != nil {
+			t.Fatalf("TestFail: error writing to ParallelWriter err:'%v'", err)
+		}
+		if err := w.Close(); err != nil {
+			t.Fatalf("TestFail: error closing ParallelWriter err:'%v'", err)
+		}
+		compressed := b.Len()
+
+		if alg == DEFLATE {
+			// trailing member without a QATzip extended header is decompressed serially
+			g := gzip.NewWriter(b)
+			g.Write([]byte(strGettysBurgAddress))
+			g.Close()
+		}
+
+		z, _ := NewParallelReader(b)
+		err := z.Apply(AlgorithmOption(alg), BlockSizeOption(MinBlockSize), WorkersOption(3))
+		if err != nil {
+			t.Fatalf("TestInit: error failed to apply parameters '%v'", err)
+		}
+
+		if alg == DEFLATE {
+			runStringCompare(str+strGettysBurgAddress, z, t)
+		} else {
+			runStringCompare(str, z, t)
+		}
+		if err = z.Close(); err != nil {
+			t.Errorf("TestFail: error closing ParallelReader err:'%v'", err)
+		}
+		if perf := z.GetPerf(); perf.BytesIn < uint64(compressed) {
+			t.Errorf("TestFail: perf counters in:%v, expected at least %v", perf.BytesIn, compressed)
+		}
+	}
+
+	// plain gzip input has no member lengths and falls back to serial decompression
+	b := new(bytes.Buffer)
+	g := gzip.NewWriter(b)
+	g.Write([]byte(str))
+	g.Close()
+
+	z, _ := NewParallelReader(b)
+	z.Apply(DeflateFmtOption(DeflateGzip))
+	runStringCompare(str, z, t)
+	z.Close()
+}
+
+func TestParallelReaderLargeMembers(t *testing.T) {
+	data := make([]byte, 9*MinBlockSize+4321)
+	rand.New(rand.NewSource(12)).Read(data)
+	str := string(data)
+
+	for _, alg := range []Algorithm{DEFLATE, ZSTD} {
+		// members larger than the reader's BlockSize are decompressed serially (QATzip splits DEFLATE blocks into
+		// members of its hardware buffer size, ZSTD blocks are single frames)
+		b := new(bytes.Buffer)
+		w := NewParallelWriter(b)
+		w.Apply(AlgorithmOption(alg), BlockSizeOption(4*MinBlockSize))
+		if _, err := w.Write([]byte(str)); err != nil {
+			t.Fatalf("TestFail: error writing to ParallelWriter err:'%v'", err)
+		}
+		if err := w.Close(); err != nil {
+			t.Fatalf("TestFail: error closing ParallelWriter err:'%v'", err)
+		}
+
+		z, _ := NewParallelReader(bytes.NewReader(b.Bytes()))
+		z.Apply(AlgorithmOption(alg), BlockSizeOption(MinBlockSize))
+		runStringCompare(str, z, t)
+		if alg == ZSTD && z.serial == nil {
+			t.Errorf("TestFail: alg:%v expected members beyond BlockSize to be decompressed serially", alg)
+		}
+		z.Close()
+
+		// blocks end before their output exceeds MaxBufferLength
+		z, _ = NewParallelReader(bytes.NewReader(b.Bytes()))
+		z.Apply(AlgorithmOption(alg), BlockSizeOption(64*MinBlockSize), MaxBufferLengthOption(6*MinBlockSize))
+		runStringCompare(str, z, t)
+		if z.serial != nil {
+			t.Errorf("TestFail: alg:%v expected members within MaxBufferLength to be decompressed in parallel", alg)
+		}
+		z.Close()
+	}
+}
+
+func TestWriterDeferLast(t *testing.T) {
+	str := randomString(MinBufferLength+5000, 5)
+
+	for _, tc := range []struct {
+		alg  Algorithm
+		dfmt DeflateFmt
+	}{{DEFLATE, DeflateGzipExt}, {DEFLATE, DeflateRaw}, {ZSTD, DeflateGzipExt}} {
+		b := new(bytes.Buffer)
+		z := NewWriter(b)
+		err := z.Apply(InputBufferModeOption(DeferLast), AlgorithmOption(tc.alg), DeflateFmtOption(tc.dfmt))
+		if err != nil {
+			t.Fatalf("TestInit: error failed to apply parameters '%v'", err)
+		}
+
+		for i := 0; i < len(str); i += 32 * 1024 {
+			j := i + 32*1024
+			if j > len(str) {
+				j = len(str)
+			}
+			if _, err = z.Write([]byte(str[i:j])); err != nil {
+				t.Fatalf("TestFail: error writing with DeferLast err:'%v'", err)
+			}
+		}
+		if err = z.Close(); err != nil {
+			t.Fatalf("TestFail: error closing Writer err:'%v'", err)
+		}
+
+		// input is compressed in place
+		if perf := z.GetPerf(); perf.CopyTimeNS != 0 {
+			t.Errorf("TestFail: expected no input copies, CopyTimeNS:%v", perf.CopyTimeNS)
+		}
+
+		var g io.Reader
+		switch {
+		case tc.alg == ZSTD:
+			g = zstd.NewReader(b)
+		case tc.dfmt == DeflateRaw:
+			g = flate.NewReader(b)
+		default:
+			if g, err = gzip.NewReader(b); err != nil {
+				t.Fatalf("TestFail: error failed to initialize compress/gzip '%v'", err)
+			}
+		}
+		runStringCompare(str, g, t)
+	}
+}
+
+func TestWriterDeferLastLZ4Raw(t *testing.T) {
+	b := new(bytes.Buffer)
+	z := NewWriter(b)
+	z.Apply(InputBufferModeOption(DeferLast), AlgorithmOption(LZ4), DeflateFmtOption(DeflateRaw))
+
+	_, err := z.Write([]byte(strGettysBurgAddress))
+	if err == ErrUnsupportedFmt {
+		t.Skip("LZ4 is not supported by current driver version, skipping this test...")
+	}
+	if err != nil {
+		t.Fatalf("TestFail: error writing with DeferLast err:'%v'", err)
+	}
+	if err = z.Close(); err != nil {
+		t.Fatalf("TestFail: error closing Writer err:'%v'", err)
+	}
+
+	// the DEFLATE format option does not apply to LZ4
+	if bytes.HasSuffix(b.Bytes(), []byte{deflateMagic1, 0, 0, deflateMagic2, deflateMagic2}) {
+		t.Fatalf("TestFail: LZ4 stream ends with a DEFLATE stored block")
+	}
+	runStringCompare(strGettysBurgAddress, lz4.NewReader(b), t)
+}
+
+func TestWriterReadFromReaderWriteTo(t *testing.T) {
+	str := randomString(3*readFromHwBuffers*defaultHwBufSize+777, 6)
+
+	for _, alg := range []Algorithm{DEFLATE, ZSTD} {
+		b := new(bytes.Buffer)
+		z := NewWriter(b)
+		z.Apply(AlgorithmOption(alg))
+
+		n, err := z.ReadFrom(bytes.NewReader([]byte(str)))
+		if err != nil || n != int64(len(str)) {
+			t.Fatalf("TestFail: ReadFrom n:%v err:'%v'", n, err)
+		}
+		if cap(z.bounceBuf) != z.p.BounceBufferLength {
+			t.Errorf("TestFail: bounce buffer cap:%v after ReadFrom", cap(z.bounceBuf))
+		}
+		if err = z.Close(); err != nil {
+			t.Fatalf("TestFail: error closing Writer err:'%v'", err)
+		}
+		if z.readFromBuf[0] != nil || z.readFromBuf[1] != nil {
+			t.Errorf("TestFail: ReadFrom buffers kept after Close")
+		}
+		if perf := z.GetPerf(); perf.CopyTimeNS != 0 {
+			t.Errorf("TestFail: expected no input copies, CopyTimeNS:%v", perf.CopyTimeNS)
+		}
+
+		r, _ := NewReader(b)
+		r.Apply(AlgorithmOption(alg))
+		s := new(bytes.Buffer)
+		n, err = r.WriteTo(s)
+		if err != nil || n != int64(len(str)) {
+			t.Fatalf("TestFail: WriteTo n:%v err:'%v'", n, err)
+		}
+		if s.String() != str {
+			t.Errorf("TestFail: WriteTo output mismatch")
+		}
+		r.Close()
+	}
+
+	// ReadFrom buffers are limited by MaxBufferLength
+	b := new(bytes.Buffer)
+	z := NewWriter(b)
+	z.Apply(MaxBufferLengthOption(MinBufferLength))
+	if _, err := z.ReadFrom(bytes.NewReader([]byte(str))); err != nil {
+		t.Fatalf("TestFail: ReadFrom err:'%v'", err)
+	}
+	if len(z.readFromBuf[0]) > MinBufferLength {
+		t.Errorf("TestFail: ReadFrom buffer of %v bytes above MaxBufferLength", len(z.readFromBuf[0]))
+	}
+	if err := z.Close(); err != nil {
+		t.Fatalf("TestFail: error closing Writer err:'%v'", err)
+	}
+	g, err := gzip.NewReader(b)
+	if err != nil {
+		t.Fatalf("TestFail: error failed to initialize compress/gzip '%v'", err)
+	}
+	runStringCompare(str, g, t)
+}
+
+func TestBufferPool(t *testing.T) {
+	for _, n := range []int{1, MinBufferLength, MinBufferLength + 1, DefaultBufferLength, DefaultMaxBufferLength} {
+		b := getBuffer(n)
+		if len(b) != n || cap(b) < n || cap(b) > 2*n+MinBufferLength {
+			t.Errorf("TestFail: getBuffer(%v) len:%v cap:%v", n, len(b), cap(b))
+		}
+		putBuffer(b)
+	}
+
+	// buffers above the largest size class are not pooled
+	if b := getBuffer(DefaultMaxBufferLength + 1); cap(b) != DefaultMaxBufferLength+1 {
+		t.Errorf("TestFail: expected unpooled buffer, cap:%v", cap(b))
+	}
+
+	for _, alg := range []Algorithm{DEFLATE, LZ4, ZSTD} {
+		for _, n := range []int{MinBufferLength, DefaultBufferLength} {
+			if m := maxInputLength(alg, n); m <= 0 || CompressBound(alg, m) > n {
+				t.Errorf("TestFail: alg:%v maxInputLength(%v):%v CompressBound:%v", alg, n, m, CompressBound(alg, m))
+			}
+		}
+	}
+}
+
+func TestMaxBufferLength(t *testing.T) {
+	str := randomString(4*MinBufferLength+999, 7)
+
+	z := NewWriter(nil)
+	if err := z.Apply(MaxBufferLengthOption(MinBufferLength - 1)); err != ErrParamMaxBufferLength {
+		t.Errorf("TestFail: expected ErrParamMaxBufferLength, got '%v'", err)
+	}
+
+	for _, alg := range []Algorithm{DEFLATE, ZSTD} {
+		b := new(bytes.Buffer)
+		z := NewWriter(b)
+		z.Apply(AlgorithmOption(alg), OutputBufLengthOption(DefaultBufferLength), MaxBufferLengthOption(MinBufferLength))
+		if err := z.Reset(b); err != nil {
+			t.Fatalf("TestFail: error resetting Writer err:'%v'", err)
+		}
+		if _, err := z.Write([]byte(str)); err != nil {
+			t.Fatalf("TestFail: error writing alg:%v err:'%v'", alg, err)
+		}
+		if err := z.Close(); err != nil {
+			t.Fatalf("TestFail: error closing Writer alg:%v err:'%v'", alg, err)
+		}
+
+		r, _ := NewReader(b)
+		r.Apply(AlgorithmOption(alg), InputBufLengthOption(MinBufferLength), OutputBufLengthOption(MinBufferLength),
+			MaxBufferLengthOption(MinBufferLength))
+		runStringCompare(str, r, t)
+		r.Close()
+	}
+}
+
+func TestCompressBlock(t *testing.T) {
+	str := randomString(3*MinBufferLength+123, 8)
+
+	for _, alg := range []Algorithm{DEFLATE, LZ4, ZSTD} {
+		dst := make([]byte, CompressBound(alg, len(str)))
+		c, err := CompressBlock(dst, []byte(str), AlgorithmOption(alg))
+		if err == ErrUnsupportedFmt {
+			continue
+		}
+		if err != nil {
+			t.Fatalf("TestFail: CompressBlock alg:%v err:'%v'", alg, err)
+		}
+		if &c[0] != &dst[0] {
+			t.Errorf("TestFail: CompressBlock alg:%v did not use dst", alg)
+		}
+
+		// exactly sized, oversized and nil destinations
+		for _, d := range [][]byte{make([]byte, 0, len(str)), make([]byte, 0, len(str)+1), nil} {
+			u, err := DecompressBlock(d, c, AlgorithmOption(alg))
+			if err != nil {
+				t.Fatalf("TestFail: DecompressBlock alg:%v cap:%v err:'%v'", alg, cap(d), err)
+			}
+			if string(u) != str {
+				t.Errorf("TestFail: DecompressBlock alg:%v cap:%v output mismatch", alg, cap(d))
+			}
+			if d != nil && &u[0] != &d[:1][0] {
+				t.Errorf("TestFail: DecompressBlock alg:%v cap:%v did not use dst", alg, cap(d))
+			}
+		}
+
+		// trailing data after the block is still rejected with an exactly sized destination
+		if _, err := DecompressBlock(make([]byte, 0, len(str)), append(c[:len(c):len(c)], 0xde, 0xad), AlgorithmOption(alg)); err == nil {
+			t.Errorf("TestFail: DecompressBlock alg:%v accepted trailing data", alg)
+		}
+
+		if alg == DEFLATE {
+			g, err := gzip.NewReader(bytes.NewReader(c))
+			if err != nil {
+				t.Fatalf("TestFail: error failed to initialize compress/gzip '%v'", err)
+			}
+			runStringCompare(str, g, t)
+		}
+
+		// empty input produces an empty stream
+		e, err := CompressBlock(nil, nil, AlgorithmOption(alg))
+		if err != nil || len(e) == 0 {
+			t.Errorf("TestFail: CompressBlock empty alg:%v len:%v err:'%v'", alg, len(e), err)
+		}
+	}
+}
+
+func TestDecompressBlockDeclaredSize(t *testing.T) {
+	// ZSTD frame declaring 64GB of content in a single empty raw block
+	frame := []byte{0x28, 0xb5, 0x2f, 0xfd, 0xe0, 0, 0, 0, 0, 0x10, 0, 0, 0, 0x01, 0, 0}
+	if _, err := DecompressBlock(nil, frame, AlgorithmOption(ZSTD)); err != ErrBuffer {
+		t.Errorf("TestFail: DecompressBlock of oversized frame expected ErrBuffer, got '%v'", err)
+	}
+}
+
+func TestCompressBatch(t *testing.T) {
+	var ins [][]byte
+	for i, n := range []int{4096, 0, 100, 3 * MinBufferLength, 4096} {
+		ins = append(ins, []byte(randomString(n, int64(i))))
+	}
+
+	for _, alg := range []Algorithm{DEFLATE, ZSTD} {
+		q, err := AcquireQzBinding(AlgorithmOption(alg))
+		if err != nil {
+			t.Fatalf("TestInit: error acquiring session '%v'", err)
+		}
+
+		outs := make([][]byte, len(ins))
+		outs[0] = make([]byte, CompressBound(alg, len(ins[0])))
+		results, err := q.CompressBatch(ins, outs)
+		if err != nil {
+			t.Fatalf("TestFail: CompressBatch alg:%v err:'%v'", alg, err)
+		}
+		if &results[0].Out[0] != &outs[0][0] {
+			t.Errorf("TestFail: CompressBatch alg:%v did not use outs[0]", alg)
+		}
+
+		for i, r := range results {
+			if r.Err != nil {
+				t.Fatalf("TestFail: CompressBatch alg:%v input:%v err:'%v'", alg, i, r.Err)
+			}
+			if len(ins[i]) > 0 && r.CRC != crc32.ChecksumIEEE(ins[i]) {
+				t.Errorf("TestFail: CompressBatch alg:%v input:%v crc mismatch", alg, i)
+			}
+			u, err := DecompressBlock(nil, r.Out, AlgorithmOption(alg))
+			if err != nil || !bytes.Equal(u, ins[i]) {
+				t.Errorf("TestFail: CompressBatch alg:%v input:%v round trip err:'%v'", alg, i, err)
+			}
+		}
+
+		if _, err = q.CompressBatch(ins, outs[:1]); err != ErrParams {
+			t.Errorf("TestFail: expected ErrParams, got '%v'", err)
+		}
+		q.Release()
+	}
+}
+
+func TestAsyncCompressor(t *testing.T) {
+	for _, mode := range []PollingMode{Periodical, Busy} {
+		a, err := NewAsyncCompressor(2, AlgorithmOption(ZSTD), PollingModeOption(mode), ReqCountThresholdOption(4))
+		if err != nil {
+			t.Fatalf("TestInit: error creating async compressor '%v'", err)
+		}
+
+		var wg sync.WaitGroup
+		for i := 0; i < 64; i++ {
+			wg.Add(1)
+			go func(i int) {
+				defer wg.Done()
+				str := randomString(1000+i*100, int64(i))
+				ticket, err := a.SubmitCompress([]byte(str), nil)
+				if err != nil {
+					t.Errorf("TestFail: SubmitCompress err:'%v'", err)
+					return
+				}
+				c, err := ticket.Wait()
+				if err != nil {
+					t.Errorf("TestFail: compress err:'%v'", err)
+					return
+				}
+				if u, err := DecompressBlock(nil, c, AlgorithmOption(ZSTD)); err != nil || string(u) != str {
+					t.Errorf("TestFail: round trip mismatch err:'%v'", err)
+				}
+			}(i)
+		}
+		wg.Wait()
+
+		if err = a.Close(); err != nil {
+			t.Errorf("TestFail: Close err:'%v'", err)
+		}
+		if _, err = a.SubmitCompress([]byte("x"), nil); err != ErrAsyncClosed {
+			t.Errorf("TestFail: expected ErrAsyncClosed, got '%v'", err)
+		}
+	}
+
+	if _, err := NewAsyncCompressor(0); err != ErrParamPollers {
+		t.Errorf("TestFail: expected ErrParamPollers, got '%v'", err)
+	}
+}
+
+func TestWriterFlush(t *testing.T) {
+	for _, tc := range []struct {
+		alg   Algorithm
+		dfmt  DeflateFmt
+		depth int
+	}{{DEFLATE, DeflateGzipExt, 0}, {DEFLATE, DeflateRaw, 0}, {ZSTD, DeflateGzipExt, 0}, {ZSTD, DeflateGzipExt, 2}, {LZ4, DeflateGzipExt, 0}} {
+		// LZ4 runs last, it skips the rest of the test where it is not supported
+		b := new(bytes.Buffer)
+		z := NewWriter(b)
+		// bounced input above minGzipSize is compressed with last=false by Flush
+		z.Apply(AlgorithmOption(tc.alg), DeflateFmtOption(tc.dfmt), PipelineDepthOption(tc.depth), BounceBufferLengthOption(2048))
+
+		written := ""
+		for i := 0; i < 4; i++ {
+			str := randomString(5000+i*3000, int64(i))
+			_, err := z.Write([]byte(str))
+			if err == ErrUnsupportedFmt {
+				t.Skip("LZ4 is not supported by current driver version, skipping this test...")
+			}
+			if err != nil {
+				t.Fatalf("TestFail: error writing alg:%v err:'%v'", tc.alg, err)
+			}
+			if err := z.Flush(); err != nil {
+				t.Fatalf("TestFail: Flush alg:%v err:'%v'", tc.alg, err)
+			}
+			written += str
+
+			// everything written so far can be decompressed before the stream ends
+			var g io.Reader
+			switch {
+			case tc.alg != DEFLATE:
+				r, _ := NewReader(bytes.NewReader(b.Bytes()))
+				r.Apply(AlgorithmOption(tc.alg))
+				defer r.Close()
+				g = r
+			case tc.dfmt == DeflateRaw:
+				g = flate.NewReader(bytes.NewReader(b.Bytes()))
+			default:
+				var err error
+				if g, err = gzip.NewReader(bytes.NewReader(b.Bytes())); err != nil {
+					t.Fatalf("TestFail: error failed to initialize compress/gzip '%v'", err)
+				}
+			}
+			s := make([]byte, len(written))
+			if _, err := io.ReadFull(g, s); err != nil || string(s) != written {
+				t.Fatalf("TestFail: alg:%v flushed output incomplete err:'%v'", tc.alg, err)
+			}
+		}
+
+		// Close right after Flush still terminates the stream
+		if err := z.Close(); err != nil {
+			t.Fatalf("TestFail: error closing Writer err:'%v'", err)
+		}
+		if tc.dfmt == DeflateRaw {
+			u, err := io.ReadAll(flate.NewReader(b))
+			if err != nil || string(u) != written {
+				t.Errorf("TestFail: raw DEFLATE stream not terminated err:'%v'", err)
+			}
+			continue
+		}
+		r, _ := NewReader(b)
+		r.Apply(AlgorithmOption(tc.alg))
+		runStringCompare(written, r, t)
+		r.Close()
+	}
+}
+
+func TestZstdDictionary(t *testing.T) {
+	r := rand.New(rand.NewSource(9))
+	record := func() []byte {
+		return []byte(fmt.Sprintf(`{"user_id":%d,"name":"user%d","email":"user%d@example.com","active":%v,"score":%d,"tags":["alpha","beta"]}`,
+			r.Intn(100000), r.Intn(1000), r.Intn(1000), r.Intn(2) == 0, r.Intn(100)))
+	}
+	samples := make([][]byte, 2000)
+	for i := range samples {
+		samples[i] = record()
+	}
+
+	dict, err := TrainZstdDictionary(samples, 4096)
+	if err == ErrNoSwAvail {
+		t.Skip("zstd is not available, skipping this test...")
+	}
+	if err != nil {
+		t.Fatalf("TestFail: TrainZstdDictionary err:'%v'", err)
+	}
+	d, err := NewZstdDictionary(dict)
+	if err != nil {
+		t.Fatalf("TestFail: NewZstdDictionary err:'%v'", err)
+	}
+
+	plain, withDict := 0, 0
+	for i := 0; i < 50; i++ {
+		rec := record()
+		c, err := CompressBlock(nil, rec, AlgorithmOption(ZSTD))
+		if err != nil {
+			t.Fatalf("TestFail: CompressBlock err:'%v'", err)
+		}
+		plain += len(c)
+
+		c, err = CompressBlock(nil, rec, AlgorithmOption(ZSTD), ZstdDictionaryOption(d))
+		if err != nil {
+			t.Fatalf("TestFail: CompressBlock with dictionary err:'%v'", err)
+		}
+		withDict += len(c)
+
+		u, err := DecompressBlock(nil, c, AlgorithmOption(ZSTD), ZstdDictionaryOption(d))
+		if err != nil || !bytes.Equal(u, rec) {
+			t.Fatalf("TestFail: DecompressBlock with dictionary err:'%v'", err)
+		}
+	}
+	if withDict >= plain {
+		t.Errorf("TestFail: dictionary did not improve ratio, %v >= %v bytes", withDict, plain)
+	}
+
+	// streaming with a dictionary
+	str := string(bytes.Join(samples[:100], []byte("\n")))
+	b := new(bytes.Buffer)
+	z := NewWriter(b)
+	z.Apply(AlgorithmOption(ZSTD), ZstdDictionaryOption(d))
+	if _, err = z.Write([]byte(str)); err != nil {
+		t.Fatalf("TestFail: error writing err:'%v'", err)
+	}
+	if err = z.Close(); err != nil {
+		t.Fatalf("TestFail: error closing Writer err:'%v'", err)
+	}
+	zr, _ := NewReader(b)
+	zr.Apply(AlgorithmOption(ZSTD), ZstdDictionaryOption(d))
+	runStringCompare(str, zr, t)
+	zr.Close()
+
+	if _, err = CompressBlock(nil, []byte(str), ZstdDictionaryOption(d)); err != ErrParamZstdDictionary {
+		t.Errorf("TestFail: expected ErrParamZstdDictionary, got '%v'", err)
+	}
+}
+
+func TestZstdAdvancedParams(t *testing.T) {
+	// compressible enough for a multithreaded frame to end with more than one output buffer
+	str := string(benchData(8 * DefaultBufferLength))
+
+	for _, tc := range []struct {
+		name    string
+		options []Option
+	}{
+		{"checksum", []Option{ZstdChecksumOption(true)}},
+		{"ldm", []Option{ZstdLongDistanceOption(true), ZstdWindowLogOption(28)}},
+		{"workers", []Option{ZstdWorkersOption(2), ZstdJobSizeOption(1024 * 1024)}},
+	} {
+		b := new(bytes.Buffer)
+		z := NewWriter(b)
+		z.Apply(append([]Option{AlgorithmOption(ZSTD), CompressionLevelOption(3)}, tc.options...)...)
+		_, err := z.Write([]byte(str))
+		if err == nil {
+			err = z.Close()
+		}
+		if err == ErrParams && tc.name == "workers" {
+			t.Logf("libzstd is built without multithreading, skipping %s", tc.name)
+			continue
+		}
+		if err != nil {
+			t.Fatalf("TestFail: %s compress err:'%v'", tc.name, err)
+		}
+
+		if tc.name == "checksum" && b.Bytes()[4]&0x04 == 0 {
+			t.Errorf("TestFail: frame has no content checksum")
+		}
+
+		r, _ := NewReader(b)
+		r.Apply(AlgorithmOption(ZSTD), ZstdWindowLogOption(28))
+		runStringCompare(str, r, t)
+		r.Close()
+	}
+
+	if err := NewWriter(nil).Apply(ZstdWindowLogOption(40)); err != ErrParamZstd {
+		t.Errorf("TestFail: expected ErrParamZstd, got '%v'", err)
+	}
+}
+
+func TestZstdDecompressFrames(t *testing.T) {
+	// concatenated single-shot frames record their content size
+	var str string
+	b := new(bytes.Buffer)
+	for i, n := range []int{4096, 3*MinBufferLength + 7, 1, 100000} {
+		s := randomString(n, int64(i))
+		c, err := CompressBlock(nil, []byte(s), AlgorithmOption(ZSTD))
+		if err != nil {
+			t.Fatalf("TestFail: CompressBlock err:'%v'", err)
+		}
+		str += s
+		b.Write(c)
+	}
+	stream := b.Bytes()
+
+	u, err := DecompressBlock(nil, stream, AlgorithmOption(ZSTD))
+	if err != nil || string(u) != str {
+		t.Fatalf("TestFail: DecompressBlock len:%v err:'%v'", len(u), err)
+	}
+
+	// frames are decoded into the caller's buffer or the output buffer
+	for _, size := range []int{len(str), 1000} {
+		r, _ := NewReader(bytes.NewReader(stream))
+		r.Apply(AlgorithmOption(ZSTD))
+		var out []byte
+		p := make([]byte, size)
+		for {
+			n, err := r.Read(p)
+			out = append(out, p[:n]...)
+			if err == io.EOF {
+				break
+			}
+			if err != nil {
+				t.Fatalf("TestFail: Read size:%v err:'%v'", size, err)
+			}
+		}
+		if string(out) != str {
+			t.Errorf("TestFail: Read size:%v output mismatch", size)
+		}
+		r.Close()
+	}
+
+	// a stream ending within a frame is an error
+	r, _ := NewReader(bytes.NewReader(stream[:len(stream)-10]))
+	r.Apply(AlgorithmOption(ZSTD))
+	if _, err := io.ReadAll(r); err != ErrData {
+		t.Errorf("TestFail: truncated stream expected ErrData, got '%v'", err)
+	}
+	r.Close()
+}
+
+func TestExecStats(t *testing.T) {
+	before := GetExecStats()
+
+	for _, size := range []int{100, 3 * MinBufferLength} {
+		str := randomString(size, 19)
+		b := new(bytes.Buffer)
+		z := NewWriter(b)
+		z.Apply(SwSwitchThresholdOption(4096))
+		if _, err := z.Write([]byte(str)); err != nil {
+			t.Fatalf("TestFail: error writing err:'%v'", err)
+		}
+		if err := z.Close(); err != nil {
+			t.Fatalf("TestFail: error closing Writer err:'%v'", err)
+		}
+
+		perf := z.GetPerf()
+		if perf.HwRequests+perf.SwRequests == 0 {
+			t.Errorf("TestFail: size:%v no requests counted %+v", size, perf.ExecStats)
+		}
+		if size < 4096 && perf.SwSmallRequests == 0 {
+			t.Errorf("TestFail: size:%v below SwSwitchThreshold not counted as software %+v", size, perf.ExecStats)
+		}
+
+		r, _ := NewReader(b)
+		runStringCompare(str, r, t)
+		if perf := r.GetPerf(); perf.HwRequests+perf.SwRequests == 0 {
+			t.Errorf("TestFail: size:%v no decompress requests counted %+v", size, perf.ExecStats)
+		}
+		r.Close()
+	}
+
+	after := GetExecStats()
+	if after.HwRequests+after.SwRequests <= before.HwRequests+before.SwRequests || after.SwSmallRequests == before.SwSmallRequests {
+		t.Errorf("TestFail: process-wide counters not updated before:%+v after:%+v", before, after)
+	}
+
+	// without software backup small inputs run on the device
+	b := new(bytes.Buffer)
+	z := NewWriter(b)
+	z.Apply(SwSwitchThresholdOption(4096), SwBackupOption(false))
+	if _, err := z.Write([]byte(strGettysBurgAddress)); err != nil {
+		t.Fatalf("TestFail: error writing err:'%v'", err)
+	}
+	if err := z.Close(); err != nil {
+		t.Fatalf("TestFail: error closing Writer err:'%v'", err)
+	}
+	if perf := z.GetPerf(); perf.SwRequests != 0 || perf.HwRequests == 0 {
+		t.Errorf("TestFail: requests without SwBackup counted as software %+v", perf.ExecStats)
+	}
+}
+
+func TestLatencyHistogram(t *testing.T) {
+	var h LatencyHistogram
+	for i := 1; i <= 10000; i++ {
+		h.Record(time.Duration(i) * time.Microsecond)
+	}
+
+	s := h.Snapshot()
+	if s.Count != 10000 || s.Max != 10*time.Millisecond {
+		t.Fatalf("TestFail: count:%v max:%v", s.Count, s.Max)
+	}
+	for _, q := range []struct {
+		got, want time.Duration
+	}{{s.P50, 5 * time.Millisecond}, {s.P99, 9900 * time.Microsecond}, {s.P999, 9990 * time.Microsecond}} {
+		if q.got < q.want || q.got > q.want+q.want/8 {
+			t.Errorf("TestFail: quantile %v, expected %v within 12.5%%", q.got, q.want)
+		}
+	}
+}
+
+func TestMetrics(t *testing.T) {
+	if err := SetMetricsSampling(1); err != nil {
+		t.Fatalf("TestFail: SetMetricsSampling err:'%v'", err)
+	}
+	defer SetMetricsSampling(0)
+	ResetMetrics()
+	before := GetMetrics()
+
+	str := randomString(3*MinBufferLength, 20)
+	b := new(bytes.Buffer)
+	z := NewWriter(b)
+	z.Write([]byte(str))
+	if err := z.Close(); err != nil {
+		t.Fatalf("TestFail: error closing Writer err:'%v'", err)
+	}
+	r, _ := NewReader(b)
+	runStringCompare(str, r, t)
+	r.Close()
+
+	m := GetMetrics()
+	for _, s := range []LatencySnapshot{m.Compress, m.Decompress} {
+		if s.Count == 0 || s.P50 > s.P99 || s.P99 > s.P999 || s.P999 > s.Max {
+			t.Errorf("TestFail: latency snapshot %+v", s)
+		}
+	}
+	if m.Streams != before.Streams+2 || m.Totals.BytesIn < before.Totals.BytesIn+uint64(len(str)) {
+		t.Errorf("TestFail: stream totals before:%+v after:%+v", before, m)
+	}
+
+	PublishMetrics("qatzip_test")
+	var exported Metrics
+	if err := json.Unmarshal([]byte(expvar.Get("qatzip_test").String()), &exported); err != nil || exported.Compress.Count == 0 {
+		t.Errorf("TestFail: expvar export %+v err:'%v'", exported, err)
+	}
+}
+
+func TestDevicePlacement(t *testing.T) {
+	root := t.TempDir()
+	for _, d := range []struct{ addr, vendor, device, node string }{
+		{"0000:3d:00.0", "0x8086", "0x4940", "0"},
+		{"0000:bd:00.0", "0x8086", "0x4940", "1"},
+		{"0000:00:1f.0", "0x8086", "0x1234", "0"},
+	} {
+		dir := filepath.Join(root, "bus/pci/devices", d.addr)
+		os.MkdirAll(dir, 0755)
+		os.WriteFile(filepath.Join(dir, "vendor"), []byte(d.vendor+"\n"), 0644)
+		os.WriteFile(filepath.Join(dir, "device"), []byte(d.device+"\n"), 0644)
+		os.WriteFile(filepath.Join(dir, "numa_node"), []byte(d.node+"\n"), 0644)
+	}
+	os.MkdirAll(filepath.Join(root, "devices/system/node/node0"), 0755)
+	os.WriteFile(filepath.Join(root, "devices/system/node/node0/cpulist"), []byte("0-3,8\n"), 0644)
+
+	placement.sysfs, placement.once = root, sync.Once{}
+	defer func() {
+		placement.sysfs, placement.once = "/sys", sync.Once{}
+	}()
+
+	devices := Devices()
+	if len(devices) != 2 || devices[0].NumaNode != 0 || devices[1].NumaNode != 1 || devices[1].Address != "0000:bd:00.0" {
+		t.Fatalf("TestFail: discovered devices %+v", devices)
+	}
+	if cpus := nodeCPUs(0); fmt.Sprint(cpus) != "[0 1 2 3 8]" {
+		t.Errorf("TestFail: node 0 cpus %v", cpus)
+	}
+
+	// explicit placement and in-flight accounting
+	if d := placeSession(1); d != 1 || Devices()[1].InFlight != 1 {
+		t.Errorf("TestFail: explicit placement on %v, devices %+v", d, Devices())
+	}
+	unplaceSession(1)
+
+	// automatic placement stays on the local node and spreads by load otherwise
+	node := currentNumaNode()
+	placed := []int{placeSession(DeviceAuto), placeSession(DeviceAuto)}
+	for _, d := range placed {
+		if (node == 0 || node == 1) && devices[d].NumaNode != node {
+			t.Errorf("TestFail: session placed on device %v (node %v) from node %v", d, devices[d].NumaNode, node)
+		}
+		unplaceSession(d)
+	}
+	if node != 0 && node != 1 && placed[0] == placed[1] {
+		t.Errorf("TestFail: sessions not spread across devices %v", placed)
+	}
+	for _, d := range Devices() {
+		if d.InFlight != 0 {
+			t.Errorf("TestFail: device %v in flight %v", d.ID, d.InFlight)
+		}
+	}
+
+	// idle sessions are reused whichever device the next checkout is placed on
+	SetSessionPoolSize(0, 2)
+	defer SetSessionPoolSize(DefaultSessionPoolMinIdle, DefaultSessionPoolMaxIdle)
+	DrainSessionPool()
+	q1, err := AcquireQzBinding(DirOption(Compress))
+	if err != nil {
+		t.Fatalf("TestFail: AcquireQzBinding err:'%v'", err)
+	}
+	if q1.device == DeviceAuto || q1.p.sessionKey().Device != DeviceAuto {
+		t.Errorf("TestFail: session placed on %v keyed by device %v", q1.device, q1.p.sessionKey().Device)
+	}
+	q1.Release()
+	for i := 0; i < len(devices); i++ {
+		q2, err := AcquireQzBinding(DirOption(Compress))
+		if err != nil {
+			t.Fatalf("TestFail: AcquireQzBinding err:'%v'", err)
+		}
+		if q2 != q1 {
+			t.Errorf("TestFail: idle session not reused on checkout %v", i)
+		}
+		q2.Release()
+	}
+	for _, d := range Devices() {
+		if d.InFlight != 0 {
+			t.Errorf("TestFail: device %v in flight %v after release", d.ID, d.InFlight)
+		}
+	}
+
+	if err := NewWriter(nil).Apply(DeviceOption(2)); err != ErrParamDevice {
+		t.Errorf("TestFail: expected ErrParamDevice, got '%v'", err)
+	}
+	if err := NewWriter(nil).Apply(DeviceOption(1)); err != nil {
+		t.Errorf("TestFail: DeviceOption(1) err:'%v'", err)
+	}
+}
+
+func TestHybridCompressor(t *testing.T) {
+	for _, alg := range []Algorithm{DEFLATE, ZSTD} {
+		h, err := NewHybridCompressor(2, AlgorithmOption(alg))
+		if err != nil {
+			t.Fatalf("TestFail: NewHybridCompressor alg:%v err:'%v'", alg, err)
+		}
+
+		// warm-up samples both paths, every output decompresses with DecompressBlock
+		const requests = 3 * hybridWarmup
+		for i := 0; i < requests; i++ {
+			str := randomString(16*1024, int64(i))
+			c, err := h.Compress(nil, []byte(str))
+			if err != nil {
+				t.Fatalf("TestFail: Compress alg:%v err:'%v'", alg, err)
+			}
+			u, err := DecompressBlock(nil, c, AlgorithmOption(alg))
+			if err != nil || string(u) != str {
+				t.Fatalf("TestFail: DecompressBlock alg:%v request:%v err:'%v'", alg, i, err)
+			}
+			z, _ := NewParallelReader(bytes.NewReader(c))
+			z.Apply(AlgorithmOption(alg))
+			runStringCompare(str, z, t)
+			if z.serial != nil {
+				t.Errorf("TestFail: alg:%v request:%v output not split by ParallelReader", alg, i)
+			}
+			z.Close()
+		}
+		if s := h.Stats(); s.HwRequests+s.SwRequests != requests || s.HwRequests < hybridWarmup || s.SwRequests < hybridWarmup {
+			t.Errorf("TestFail: alg:%v routed %+v", alg, s)
+		}
+	}
+
+	// software output in the default format records member sizes in one member per hardware buffer
+	str := randomString(3*defaultHwBufSize+100, 3)
+	c, err := softwareCompress(defaultParams(), nil, []byte(str))
+	if err != nil {
+		t.Fatalf("TestFail: softwareCompress err:'%v'", err)
+	}
+	if n := blockSize(DEFLATE, c); n != len(str) {
+		t.Errorf("TestFail: software gzip members record %v bytes, expected %v", n, len(str))
+	}
+	if u, err := DecompressBlock(nil, c); err != nil || string(u) != str {
+		t.Errorf("TestFail: DecompressBlock of software output err:'%v'", err)
+	}
+
+	// a saturated device loses to software of equal unloaded speed
+	if hybridPredict(1, 1000, 1, 4) != 1000 || hybridPredict(1, 1000, 8, 4) <= 1000 {
+		t.Errorf("TestFail: hybridPredict does not account for queued requests")
+	}
+
+	if _, err := NewHybridCompressor(0); err != ErrParamHybridDepth {
+		t.Errorf("TestFail: expected ErrParamHybridDepth, got '%v'", err)
+	}
+}
+
+func TestSeekable(t *testing.T) {
+	str := randomString(10*MinBlockSize+1234, 7)
+	for _, alg := range []Algorithm{DEFLATE, ZSTD} {
+		var buf bytes.Buffer
+		w := NewParallelWriter(&buf)
+		if err := w.Apply(AlgorithmOption(alg), BlockSizeOption(MinBlockSize), SeekableOption(true)); err != nil {
+			t.Fatalf("TestFail: Apply alg:%v err:'%v'", alg, err)
+		}
+		if _, err := w.Write([]byte(str)); err != nil {
+			t.Fatalf("TestFail: Write alg:%v err:'%v'", alg, err)
+		}
+		if err := w.Close(); err != nil {
+			t.Fatalf("TestFail: Close alg:%v err:'%v'", alg, err)
+		}
+
+		// the seek table is ignored by standard decompressors
+		var u []byte
+		var err error
+		if alg == DEFLATE {
+			var g *gzip.Reader
+			if g, err = gzip.NewReader(bytes.NewReader(buf.Bytes())); err == nil {
+				u, err = io.ReadAll(g)
+			}
+		} else {
+			u, err = zstd.Decompress(nil, buf.Bytes())
+		}
+		if err != nil || string(u) != str {
+			t.Fatalf("TestFail: sequential decompress alg:%v err:'%v'", alg, err)
+		}
+
+		r, err := NewSeekableReader(bytes.NewReader(buf.Bytes()), int64(buf.Len()), AlgorithmOption(alg))
+		if err != nil {
+			t.Fatalf("TestFail: NewSeekableReader alg:%v err:'%v'", alg, err)
+		}
+		if r.Size() != int64(len(str)) {
+			t.Fatalf("TestFail: Size alg:%v %v != %v", alg, r.Size(), len(str))
+		}
+
+		// reads within a block, across blocks and past the end
+		for _, c := range []struct{ off, n int }{{0, 10}, {MinBlockSize - 5, 10}, {3*MinBlockSize + 7, 2*MinBlockSize + 1}, {len(str) - 4, 4}} {
+			p := make([]byte, c.n)
+			if n, err := r.ReadAt(p, int64(c.off)); n != c.n || err != nil || string(p) != str[c.off:c.off+c.n] {
+				t.Errorf("TestFail: ReadAt alg:%v off:%v n:%v err:'%v'", alg, c.off, n, err)
+			}
+		}
+		if n, err := r.ReadAt(make([]byte, 8), int64(len(str)-4)); n != 4 || err != io.EOF {
+			t.Errorf("TestFail: ReadAt past end alg:%v n:%v err:'%v'", alg, n, err)
+		}
+
+		if _, err := r.Seek(int64(len(str)/2), io.SeekStart); err != nil {
+			t.Fatalf("TestFail: Seek alg:%v err:'%v'", alg, err)
+		}
+		if u, err := io.ReadAll(r); err != nil || string(u) != str[len(str)/2:] {
+			t.Errorf("TestFail: Read after Seek alg:%v err:'%v'", alg, err)
+		}
+
+		if _, err := NewSeekableReader(bytes.NewReader(buf.Bytes()), int64(buf.Len()-1), AlgorithmOption(alg)); err != ErrSeekTable {
+			t.Errorf("TestFail: truncated stream alg:%v expected ErrSeekTable, got '%v'", alg, err)
+		}
+	}
+
+	// gzip tables larger than one FEXTRA field span several members
+	entries := make([]seekEntry, seekGzipEntries+10)
+	for i := range entries {
+		entries[i] = seekEntry{csize: 0, usize: uint32(i), crc: uint32(i * 3)}
+	}
+	table := appendSeekTable(nil, DEFLATE, entries)
+	read, checksums, err := readSeekTable(bytes.NewReader(table), int64(len(table)), DefaultMaxBufferLength)
+	if err != nil || !checksums || len(read) != len(entries) || read[len(read)-1] != entries[len(entries)-1] {
+		t.Errorf("TestFail: multi-member seek table entries:%v checksums:%v err:'%v'", len(read), checksums, err)
+	}
+
+	// blocks are not decompressed beyond MaxBufferLength
+	entries = []seekEntry{{csize: 0, usize: DefaultMaxBufferLength}}
+	table = appendSeekTable(nil, ZSTD, entries)
+	if _, _, err = readSeekTable(bytes.NewReader(table), int64(len(table)), DefaultMaxBufferLength); err != ErrSeekTable {
+		t.Errorf("TestFail: oversized seek table entry expected ErrSeekTable, got '%v'", err)
+	}
+}
+
+func TestTraceGating(t *testing.T) {
+	if getTraceLevel() >= High {
+		t.Skip("debug output enabled by " + debugLevelEnv)
+	}
+
+	q, err := AcquireQzBinding()
+	if err != nil {
+		t.Fatalf("TestFail: AcquireQzBinding err:'%v'", err)
+	}
+	defer q.Release()
+
+	// without an execution trace or DebugLevel High nothing is formatted or recorded
+	if traceOn(Med, nil) || traceOn(Med, q) || startRegion(context.Background(), "test") != nil {
+		t.Errorf("TestFail: tracing enabled without a running trace")
+	}
+	endRegion(nil)
+
+	if allocs := testing.AllocsPerRun(100, func() {
+		if traceOn(Med, q) {
+			traceLogf(Med, q, context.Background(), "i:%v o:%v", 1<<20, 1<<21)
+		}
+	}); allocs != 0 {
+		t.Errorf("TestFail: disabled trace message allocates %v times", allocs)
+	}
+}
+
+func TestCompressFile(t *testing.T) {
+	dir := t.TempDir()
+	src := filepath.Join(dir, "data")
+	str := randomString(3*MinBlockSize+99, 3)
+	if err := os.WriteFile(src, []byte(str), 0644); err != nil {
+		t.Fatal(err)
+	}
+
+	for _, workers := range []int{1, 4} {
+		options := []Option{WorkersOption(workers), BlockSizeOption(MinBlockSize), OutputBufLengthOption(MinBufferLength)}
+		perf, err := CompressFile(src, src+".gz", options...)
+		if err != nil || perf.BytesIn != uint64(len(str)) {
+			t.Fatalf("TestFail: CompressFile workers:%v BytesIn:%v err:'%v'", workers, perf.BytesIn, err)
+		}
+		if _, err = DecompressFile(src+".gz", src+".out", WorkersOption(workers), InputBufLengthOption(MinBufferLength)); err != nil {
+			t.Fatalf("TestFail: DecompressFile workers:%v err:'%v'", workers, err)
+		}
+		if u, err := os.ReadFile(src + ".out"); err != nil || string(u) != str {
+			t.Errorf("TestFail: file round trip workers:%v err:'%v'", workers, err)
+		}
+	}
+
+	// pipes are streamed
+	pr, pw, err := os.Pipe()
+	if err != nil {
+		t.Fatal(err)
+	}
+	go func() {
+		pw.Write([]byte(str))
+		pw.Close()
+	}()
+	var buf bytes.Buffer
+	if _, err = CompressFileTo(&buf, pr); err != nil {
+		t.Fatalf("TestFail: CompressFileTo pipe err:'%v'", err)
+	}
+	pr.Close()
+	if u, err := DecompressBlock(nil, buf.Bytes()); err != nil || string(u) != str {
+		t.Errorf("TestFail: pipe round trip err:'%v'", err)
+	}
+
+	if _, err := CompressFile(src, src+".gz", InputBufLengthOption(MinBufferLength)); err != ErrApplyInvalidType {
+		t.Errorf("TestFail: expected ErrApplyInvalidType, got '%v'", err)
+	}
+}
+
+func TestChecksum(t *testing.T) {
+	str := []byte(randomString(3*MinBlockSize+77, 3))
+	split := len(str) / 3
+	for _, kind := range []ChecksumKind{CRC32, CRC32C, CRC64} {
+		whole, err := Checksum(str, kind)
+		if err != nil {
+			t.Fatalf("TestFail: Checksum kind:%v err:'%v'", kind, err)
+		}
+		crc1, _ := Checksum(str[:split], kind)
+		crc2, _ := Checksum(str[split:], kind)
+		if c, err := ChecksumCombine(kind, crc1, crc2, int64(len(str)-split)); err != nil || c != whole {
+			t.Errorf("TestFail: ChecksumCombine kind:%v %x != %x err:'%v'", kind, c, whole, err)
+		}
+	}
+	if CRC32Combine(crc32.ChecksumIEEE(str[:split]), crc32.ChecksumIEEE(str[split:]), int64(len(str)-split)) != crc32.ChecksumIEEE(str) {
+		t.Errorf("TestFail: CRC32Combine")
+	}
+	if _, err := Checksum(str, ChecksumKind(-1)); err != ErrParamChecksum {
+		t.Errorf("TestFail: expected ErrParamChecksum, got '%v'", err)
+	}
+
+	// the parallel reader combines the block CRCs
+	for _, alg := range []Algorithm{DEFLATE, ZSTD} {
+		var buf bytes.Buffer
+		w := NewParallelWriter(&buf)
+		if err := w.Apply(AlgorithmOption(alg), BlockSizeOption(MinBlockSize)); err != nil {
+			t.Fatalf("TestFail: Apply alg:%v err:'%v'", alg, err)
+		}
+		w.Write(str)
+		if err := w.Close(); err != nil {
+			t.Fatalf("TestFail: Close alg:%v err:'%v'", alg, err)
+		}
+
+		r, _ := NewParallelReader(&buf)
+		if err := r.Apply(AlgorithmOption(alg)); err != nil {
+			t.Fatalf("TestFail: Apply alg:%v err:'%v'", alg, err)
+		}
+		u, err := io.ReadAll(r)
+		if err != nil || !bytes.Equal(u, str) {
+			t.Fatalf("TestFail: ReadAll alg:%v err:'%v'", alg, err)
+		}
+		if r.CRC32() != crc32.ChecksumIEEE(str) {
+			t.Errorf("TestFail: CRC32 alg:%v %x != %x", alg, r.CRC32(), crc32.ChecksumIEEE(str))
+		}
+		r.Close()
+	}
+}
+
+func TestStoreIncompressible(t *testing.T) {
+	noise := make([]byte, 5*storeSegment)
+	rand.New(rand.NewSource(5)).Read(noise)
+	data := []byte(randomString(3*storeSegment, 1))
+	data = append(data, noise...)
+	data = append(data, randomString(storeSegment+100, 2)...)
+
+	// the Writer stores the noise and compresses the text on either side
+	var buf bytes.Buffer
+	w := NewWriter(&buf)
+	if err := w.Apply(StoreIncompressibleOption(true)); err != nil {
+		t.Fatalf("TestFail: Apply err:'%v'", err)
+	}
+	if _, err := w.Write(data); err != nil {
+		t.Fatalf("TestFail: Write err:'%v'", err)
+	}
+	if err := w.Close(); err != nil {
+		t.Fatalf("TestFail: Close err:'%v'", err)
+	}
+	if p := w.GetPerf(); p.BytesStored != uint64(len(noise)) || p.BytesIn != uint64(len(data)) {
+		t.Errorf("TestFail: stored %v of %v bytes, expected %v", p.BytesStored, p.BytesIn, len(noise))
+	}
+	g, err := gzip.NewReader(bytes.NewReader(buf.Bytes()))
+	if err != nil {
+		t.Fatalf("TestFail: gzip.NewReader err:'%v'", err)
+	}
+	if u, err := io.ReadAll(g); err != nil || !bytes.Equal(u, data) {
+		t.Errorf("TestFail: gzip err:'%v'", err)
+	}
+
+	// a ZSTD frame open before the noise is ended so that the noise is stored
+	buf.Reset()
+	w = NewWriter(&buf)
+	w.Apply(AlgorithmOption(ZSTD), StoreIncompressibleOption(true))
+	if _, err := w.Write(data); err != nil {
+		t.Fatalf("TestFail: Write ZSTD err:'%v'", err)
+	}
+	if err := w.Close(); err != nil {
+		t.Fatalf("TestFail: Close ZSTD err:'%v'", err)
+	}
+	if p := w.GetPerf(); p.BytesStored != uint64(len(noise)) {
+		t.Errorf("TestFail: ZSTD stored %v bytes, expected %v", p.BytesStored, len(noise))
+	}
+	zr, _ := NewReader(bytes.NewReader(buf.Bytes()))
+	zr.Apply(AlgorithmOption(ZSTD))
+	runStringCompare(string(data), zr, t)
+	zr.Close()
+
+	// stored gzip members with the QZ extra field are no larger than a hardware buffer
+	stored := appendStored(defaultParams(), nil, noise)
+	if len(stored) != storedLength(defaultParams(), len(noise)) {
+		t.Errorf("TestFail: stored gzip length %v, expected %v", len(stored), storedLength(defaultParams(), len(noise)))
+	}
+	s := memberScanner{alg: DEFLATE, ensure: func(n int) error { return nil }, buf: func() []byte { return stored }}
+	for start := 0; start < len(stored); {
+		size, usize, err := s.next(start)
+		if err != nil || usize > defaultHwBufSize {
+			t.Fatalf("TestFail: stored gzip member of %v bytes err:'%v'", usize, err)
+		}
+		start += size
+	}
+
+	// stored blocks decompress on the parallel reader and keep the stream CRC
+	for _, alg := range []Algorithm{DEFLATE, ZSTD} {
+		buf.Reset()
+		pw := NewParallelWriter(&buf)
+		if err := pw.Apply(AlgorithmOption(alg), BlockSizeOption(storeSegment), StoreIncompressibleOption(true)); err != nil {
+			t.Fatalf("TestFail: Apply alg:%v err:'%v'", alg, err)
+		}
+		pw.Write(data)
+		if err := pw.Close(); err != nil {
+			t.Fatalf("TestFail: Close alg:%v err:'%v'", alg, err)
+		}
+		if p := pw.GetPerf(); p.BytesStored != uint64(len(noise)) {
+			t.Errorf("TestFail: alg:%v stored %v bytes, expected %v", alg, p.BytesStored, len(noise))
+		}
+
+		r, _ := NewParallelReader(&buf)
+		r.Apply(AlgorithmOption(alg))
+		u, err := io.ReadAll(r)
+		if err != nil || !bytes.Equal(u, data) {
+			t.Errorf("TestFail: ParallelReader alg:%v err:'%v'", alg, err)
+		}
+		if r.CRC32() != crc32.ChecksumIEEE(data) {
+			t.Errorf("TestFail: CRC32 alg:%v", alg)
+		}
+		r.Close()
+	}
+
+	// LZ4 and ZSTD frames are located by the member scanner
+	for _, alg := range []Algorithm{LZ4, ZSTD} {
+		p := defaultParams()
+		p.Algorithm = alg
+		frame := appendStored(p, nil, noise)
+		s := memberScanner{alg: alg, ensure: func(n int) error { return nil }, buf: func() []byte { return frame }}
+		if size, _, err := s.next(0); err != nil || size != len(frame) || size != storedLength(p, len(noise)) {
+			t.Errorf("TestFail: scan alg:%v size:%v len:%v err:'%v'", alg, size, len(frame), err)
+		}
+	}
+
+	r, _ := NewReader(nil)
+	if err := r.Apply(StoreIncompressibleOption(true)); err != ErrApplyInvalidType {
+		t.Errorf("TestFail: expected ErrApplyInvalidType, got '%v'", err)
+	}
+}
+
+func TestPinnedBuffers(t *testing.T) {
+	str := randomString(3*MinBufferLength, 9)
+	src, err := AllocBuffer(len(str))
+	if err == ErrNoMem {
+		t.Skip("no pinned memory, skipping this test...")
+	} else if err != nil {
+		t.Fatalf("TestFail: AllocBuffer err:'%v'", err)
+	}
+	dst, _ := AllocBuffer(CompressBound(DEFLATE, len(str)))
+	out, _ := AllocBuffer(len(str) + 1)
+	copy(src, str)
+
+	// blocks are compressed from and into pinned memory without reallocation
+	c, err := CompressBlock(dst, src)
+	if err != nil || &c[0] != &dst[0] {
+		t.Fatalf("TestFail: CompressBlock err:'%v'", err)
+	}
+	if u, err := DecompressBlock(out, c); err != nil || string(u) != str || &u[0] != &out[0] {
+		t.Errorf("TestFail: DecompressBlock err:'%v'", err)
+	}
+	for _, b := range [][]byte{src, dst, out} {
+		if err := FreeBuffer(b); err != nil {
+			t.Errorf("TestFail: FreeBuffer err:'%v'", err)
+		}
+	}
+	if err := FreeBuffer(src); err != ErrNotPinned {
+		t.Errorf("TestFail: double FreeBuffer expected ErrNotPinned, got '%v'", err)
+	}
+	if err := FreeBuffer(make([]byte, 16)); err != ErrNotPinned {
+		t.Errorf("TestFail: FreeBuffer of Go memory expected ErrNotPinned, got '%v'", err)
+	}
+	if _, err := AllocBuffer(0); err != ErrParams {
+		t.Errorf("TestFail: AllocBuffer(0) expected ErrParams, got '%v'", err)
+	}
+
+	// stream buffers come from pinned memory up to the limit and are freed once idle
+	if err := SetPinnedBufferLimit(16 * DefaultBufferLength); err != nil {
+		t.Fatalf("TestFail: SetPinnedBufferLimit err:'%v'", err)
+	}
+	var buf bytes.Buffer
+	w := NewWriter(&buf)
+	w.Write([]byte(str))
+	if err := w.Close(); err != nil {
+		t.Fatalf("TestFail: Close err:'%v'", err)
+	}
+	r, _ := NewReader(&buf)
+	if u, err := io.ReadAll(r); err != nil || string(u) != str {
+		t.Errorf("TestFail: Reader err:'%v'", err)
+	}
+	r.Close()
+	if atomic.LoadInt64(&pinned.size) == 0 {
+		t.Errorf("TestFail: no pinned stream buffers allocated")
+	}
+	SetPinnedBufferLimit(0)
+	if n := atomic.LoadInt64(&pinned.size); n != 0 {
+		t.Errorf("TestFail: %v pinned bytes left after SetPinnedBufferLimit(0)", n)
+	}
+	if err := SetPinnedBufferLimit(-1); err != ErrParams {
+		t.Errorf("TestFail: expected ErrParams, got '%v'", err)
+	}
+}
+
+func TestReadAhead(t *testing.T) {
+	str := randomString(4*1024*1024, 4)
+	var buf bytes.Buffer
+	w := NewWriter(&buf)
+	w.Write([]byte(str))
+	if err := w.Close(); err != nil {
+		t.Fatalf("TestFail: Close err:'%v'", err)
+	}
+	compressed := buf.Bytes()
+
+	// prefetched chunks are decompressed in order and the fetch time is reported separately
+	c := &countingReader{r: bytes.NewReader(compressed)}
+	r, _ := NewReader(c)
+	if err := r.Apply(ReadAheadOption(4, 64*1024)); err != nil {
+		t.Fatalf("TestFail: Apply err:'%v'", err)
+	}
+	u, err := io.ReadAll(r)
+	if err != nil || string(u) != str {
+		t.Fatalf("TestFail: ReadAll err:'%v'", err)
+	}
+	if p := r.GetPerf(); p.PrefetchTimeNS == 0 {
+		t.Errorf("TestFail: PrefetchTimeNS not recorded")
+	}
+	if err := r.Close(); err != nil {
+		t.Errorf("TestFail: Close err:'%v'", err)
+	}
+	if c.n != len(compressed) {
+		t.Errorf("TestFail: read %v of %v compressed bytes", c.n, len(compressed))
+	}
+
+	// input errors are returned by Read, Close stops read-ahead mid-stream
+	errInput := errors.New("input failed")
+	r, _ = NewReader(io.MultiReader(bytes.NewReader(compressed[:len(compressed)/2]), iotestErrReader{errInput}))
+	r.Apply(ReadAheadOption(2, 32*1024))
+	if _, err := io.ReadAll(r); err != errInput {
+		t.Errorf("TestFail: expected input error, got '%v'", err)
+	}
+	r.Close()
+
+	r, _ = NewReader(bytes.NewReader(compressed))
+	r.Apply(ReadAheadOption(2, 32*1024))
+	if _, err := r.Read(make([]byte, 1024)); err != nil {
+		t.Fatalf("TestFail: Read err:'%v'", err)
+	}
+	r.Close()
+
+	r, _ = NewReader(nil)
+	if err := r.Apply(ReadAheadOption(-1, 0)); err != ErrParamReadAhead {
+		t.Errorf("TestFail: expected ErrParamReadAhead, got '%v'", err)
+	}
+	if err := NewWriter(nil).Apply(ReadAheadOption(1, 1024)); err != ErrApplyInvalidType {
+		t.Errorf("TestFail: expected ErrApplyInvalidType, got '%v'", err)
+	}
+}
+
+// returns err on every Read
+type iotestErrReader struct {
+	err error
+}
+
+func (e iotestErrReader) Read(p []byte) (int, error) {
+	return 0, e.err
+}
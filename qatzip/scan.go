@@ -0,0 +1,229 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+package qatzip
+
+import (
+	"encoding/binary"
+	"errors"
+)
+
+const (
+	/* QATzip extended gzip header (DeflateGzipExt) */
+	gzipFlagExtra uint8 = 0x04
+	qzExtraID1    uint8 = 'Q'
+	qzExtraID2    uint8 = 'Z'
+	qzExtraLen          = 8 // src_sz, dest_sz
+
+	/* ZSTD frame magic numbers */
+	zstdMagic         uint32 = 0xFD2FB528
+	zstdSkippableMask uint32 = 0xFFFFFFF0
+	zstdSkippableID   uint32 = 0x184D2A50
+)
+
+// Member boundaries could not be determined from the headers
+var errNotScannable = errors.New(QatErrHdr + "member boundaries are not recorded in the stream")
+
+// Locates complete gzip members, LZ4 frames or ZSTD frames from their headers without decompressing them.
+// ensure(n) must make at least n bytes available in buf() or return an error.
+type memberScanner struct {
+	alg    Algorithm
+	ensure func(n int) error
+	buf    func() []byte
+}
+
+// Returns the compressed length of the member starting at start and its uncompressed length (-1 if unknown)
+func (s *memberScanner) next(start int) (size int, usize int, err error) {
+	switch s.alg {
+	case DEFLATE:
+		return s.gzipExt(start)
+	case LZ4:
+		return s.lz4(start)
+	case ZSTD:
+		return s.zstd(start)
+	}
+	return 0, 0, errNotScannable
+}
+
+// Makes n bytes from start available and returns them
+func (s *memberScanner) bytes(start int, n int) ([]byte, error) {
+	if err := s.ensure(start + n); err != nil {
+		return nil, err
+	}
+	return s.buf()[start : start+n], nil
+}
+
+// QATzip gzip member: 10 byte header, FEXTRA with a QZ subfield carrying src_sz and dest_sz, deflate data, 8 byte footer
+func (s *memberScanner) gzipExt(start int) (size int, usize int, err error) {
+	var le = binary.LittleEndian
+
+	h, err := s.bytes(start, 12)
+	if err != nil {
+		return 0, 0, err
+	}
+	if h[0] != gzipID1 || h[1] != gzipID2 || h[2] != gzipDeflate || h[3] != gzipFlagExtra {
+		return 0, 0, errNotScannable
+	}
+
+	xlen := int(le.Uint16(h[10:]))
+	x, err := s.bytes(start+12, xlen)
+	if err != nil {
+		return 0, 0, err
+	}
+
+	for len(x) >= 4 {
+		sublen := int(le.Uint16(x[2:]))
+		if sublen > len(x)-4 {
+			break
+		}
+		if x[0] == qzExtraID1 && x[1] == qzExtraID2 && sublen >= qzExtraLen {
+			usize = int(le.Uint32(x[4:]))
+			size = 12 + xlen + int(le.Uint32(x[8:])) + 8
+			return size, usize, s.ensure(start + size)
+		}
+		x = x[4+sublen:]
+	}
+
+	return 0, 0, errNotScannable
+}
+
+// LZ4 frame: header, blocks prefixed by their size, end mark and optional content checksum
+func (s *memberScanner) lz4(start int) (size int, usize int, err error) {
+	var le = binary.LittleEndian
+
+	h, err := s.bytes(start, 7)
+	if err != nil {
+		return 0, 0, err
+	}
+
+	magic := le.Uint32(h)
+	if magic&zstdSkippableMask == zstdSkippableID {
+		return s.skippable(start)
+	}
+	flg := h[4]
+	if magic != lz4ID || flg>>6 != 1 {
+		return 0, 0, errNotScannable
+	}
+
+	blockChecksum := flg&0x10 != 0
+	contentSize := flg&0x08 != 0
+	contentChecksum := flg&0x04 != 0
+
+	usize = -1
+	off := 7
+	if contentSize {
+		cs, err := s.bytes(start+6, 8)
+		if err != nil {
+			return 0, 0, err
+		}
+		usize = int(le.Uint64(cs))
+		off += 8
+	}
+	if flg&0x01 != 0 {
+		off += 4 // dictionary ID
+	}
+
+	for {
+		b, err := s.bytes(start+off, 4)
+		if err != nil {
+			return 0, 0, err
+		}
+		bs := le.Uint32(b)
+		off += 4
+		if bs == 0 {
+			break
+		}
+		off += int(bs & 0x7fffffff)
+		if blockChecksum {
+			off += 4
+		}
+	}
+	if contentChecksum {
+		off += 4
+	}
+
+	return off, usize, s.ensure(start + off)
+}
+
+// ZSTD frame: header with optional content size, blocks with 3 byte headers and optional checksum
+func (s *memberScanner) zstd(start int) (size int, usize int, err error) {
+	var le = binary.LittleEndian
+
+	h, err := s.bytes(start, 5)
+	if err != nil {
+		return 0, 0, err
+	}
+
+	magic := le.Uint32(h)
+	if magic&zstdSkippableMask == zstdSkippableID {
+		return s.skippable(start)
+	}
+	if magic != zstdMagic {
+		return 0, 0, errNotScannable
+	}
+
+	fhd := h[4]
+	singleSegment := fhd&0x20 != 0
+	checksum := fhd&0x04 != 0
+	dictIDSize := [4]int{0, 1, 2, 4}[fhd&0x03]
+	fcsSize := [4]int{0, 2, 4, 8}[fhd>>6]
+	if fcsSize == 0 && singleSegment {
+		fcsSize = 1
+	}
+
+	off := 5 + dictIDSize
+	if !singleSegment {
+		off++ // window descriptor
+	}
+
+	usize = -1
+	if fcsSize > 0 {
+		f, err := s.bytes(start+off, fcsSize)
+		if err != nil {
+			return 0, 0, err
+		}
+		switch fcsSize {
+		case 1:
+			usize = int(f[0])
+		case 2:
+			usize = int(le.Uint16(f)) + 256
+		case 4:
+			usize = int(le.Uint32(f))
+		case 8:
+			usize = int(le.Uint64(f))
+		}
+		off += fcsSize
+	}
+
+	for last := false; !last; {
+		b, err := s.bytes(start+off, 3)
+		if err != nil {
+			return 0, 0, err
+		}
+		bh := uint32(b[0]) | uint32(b[1])<<8 | uint32(b[2])<<16
+		last = bh&1 != 0
+		off += 3
+		switch (bh >> 1) & 3 {
+		case 0, 2: // raw, compressed
+			off += int(bh >> 3)
+		case 1: // RLE
+			off++
+		default:
+			return 0, 0, errNotScannable
+		}
+	}
+	if checksum {
+		off += 4
+	}
+
+	return off, usize, s.ensure(start + off)
+}
+
+// Skippable frame (LZ4 and ZSTD): magic, 4 byte length, user data
+func (s *memberScanner) skippable(start int) (size int, usize int, err error) {
+	h, err := s.bytes(start, 8)
+	if err != nil {
+		return 0, 0, err
+	}
+	size = 8 + int(binary.LittleEndian.Uint32(h[4:]))
+	return size, 0, s.ensure(start + size)
+}
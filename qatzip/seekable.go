@@ -0,0 +1,353 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+package qatzip
+
+import (
+	"encoding/binary"
+	"hash/crc32"
+	"io"
+	"math"
+	"sort"
+	"sync"
+)
+
+const (
+	/* seek table footer, as in the ZSTD seekable format */
+	seekTableMagic   uint32 = 0x8F92EAB1
+	seekSkippableID  uint32 = 0x184D2A5E
+	seekFooterLen           = 9    // number of entries, descriptor, magic
+	seekChecksumFlag uint8  = 0x80 // entries carry the CRC-32 of the block
+	seekContinued    uint8  = 0x01 // the table continues in the preceding gzip member
+
+	/* gzip members carrying the seek table in an FEXTRA subfield */
+	seekExtraID1    uint8 = 'Q'
+	seekExtraID2    uint8 = 'S'
+	seekGzipHdrLen        = 16   // header, XLEN and subfield header
+	seekGzipTailLen       = 10   // empty final block, CRC-32 and ISIZE of an empty member
+	seekGzipEntries       = 4096 // entries per member, FEXTRA holds at most 64KB
+)
+
+// Compressed size, uncompressed size and CRC-32 of one block
+type seekEntry struct {
+	csize uint32
+	usize uint32
+	crc   uint32
+}
+
+// Appends the seek table of entries to buf. ZSTD and LZ4 use a skippable frame laid out as the
+// ZSTD seekable format, gzip uses empty members with the table in an FEXTRA subfield.
+// CRC-32s are recorded for gzip and LZ4, the ZSTD format reserves the field for XXH64.
+func appendSeekTable(buf []byte, alg Algorithm, entries []seekEntry) []byte {
+	checksums := alg != ZSTD
+	entryLen := 8
+	descriptor := uint8(0)
+	if checksums {
+		entryLen = 12
+		descriptor = seekChecksumFlag
+	}
+
+	append16 := func(buf []byte, v uint16) []byte { return append(buf, uint8(v), uint8(v>>8)) }
+	append32 := func(buf []byte, v uint32) []byte {
+		return append(buf, uint8(v), uint8(v>>8), uint8(v>>16), uint8(v>>24))
+	}
+
+	appendTable := func(buf []byte, entries []seekEntry, descriptor uint8) []byte {
+		for _, e := range entries {
+			buf = append32(buf, e.csize)
+			buf = append32(buf, e.usize)
+			if checksums {
+				buf = append32(buf, e.crc)
+			}
+		}
+		buf = append32(buf, uint32(len(entries)))
+		buf = append(buf, descriptor)
+		return append32(buf, seekTableMagic)
+	}
+
+	if alg != DEFLATE {
+		buf = append32(buf, seekSkippableID)
+		buf = append32(buf, uint32(len(entries)*entryLen+seekFooterLen))
+		return appendTable(buf, entries, descriptor)
+	}
+
+	for i := 0; i == 0 || i < len(entries); i += seekGzipEntries {
+		chunk := entries[i:minInt(i+seekGzipEntries, len(entries))]
+		d := descriptor
+		if i > 0 {
+			d |= seekContinued
+		}
+		payload := len(chunk)*entryLen + seekFooterLen
+		buf = append(buf, gzipID1, gzipID2, gzipDeflate, gzipFlagExtra, 0, 0, 0, 0, 0, 255)
+		buf = append16(buf, uint16(4+payload))
+		buf = append(buf, seekExtraID1, seekExtraID2)
+		buf = append16(buf, uint16(payload))
+		buf = appendTable(buf, chunk, d)
+		buf = append(buf, 0x03, 0x00, 0, 0, 0, 0, 0, 0, 0, 0)
+	}
+	return buf
+}
+
+// Reads n bytes at off, any short read means the table is missing or truncated
+func readSeekBytes(r io.ReaderAt, off int64, n int64) ([]byte, error) {
+	if off < 0 || n < 0 {
+		return nil, ErrSeekTable
+	}
+	b := make([]byte, n)
+	if c, err := r.ReadAt(b, off); c < len(b) {
+		if err == nil || err == io.EOF {
+			err = ErrSeekTable
+		}
+		return nil, err
+	}
+	return b, nil
+}
+
+// Reads the seek table at the end of the size bytes of r, blocks must decompress to less than max bytes
+func readSeekTable(r io.ReaderAt, size int64, max int) (entries []seekEntry, checksums bool, err error) {
+	var le = binary.LittleEndian
+
+	parse := func(table []byte, n int, entryLen int) []seekEntry {
+		e := make([]seekEntry, n)
+		for i := range e {
+			t := table[i*entryLen:]
+			e[i].csize = le.Uint32(t)
+			e[i].usize = le.Uint32(t[4:])
+			if entryLen == 12 {
+				e[i].crc = le.Uint32(t[8:])
+			}
+		}
+		return e
+	}
+
+	end := size
+	for first := true; ; first = false {
+		inMember := false
+		footer, err := readSeekBytes(r, end-seekFooterLen, seekFooterLen)
+		if err == nil && le.Uint32(footer[5:]) != seekTableMagic {
+			inMember = true
+			footer, err = readSeekBytes(r, end-seekGzipTailLen-seekFooterLen, seekFooterLen+seekGzipTailLen)
+		}
+		if err != nil {
+			return nil, false, err
+		}
+		if inMember && (le.Uint32(footer[5:]) != seekTableMagic || footer[9] != 0x03 || le.Uint64(footer[11:]) != 0) {
+			return nil, false, ErrSeekTable
+		}
+
+		n := int64(le.Uint32(footer))
+		descriptor := footer[4]
+		if first {
+			checksums = descriptor&seekChecksumFlag != 0
+		} else if checksums != (descriptor&seekChecksumFlag != 0) {
+			return nil, false, ErrSeekTable
+		}
+		entryLen := int64(8)
+		if checksums {
+			entryLen = 12
+		}
+		payload := n*entryLen + seekFooterLen
+		if payload > end {
+			return nil, false, ErrSeekTable
+		}
+
+		if !inMember {
+			start := end - payload - 8
+			frame, err := readSeekBytes(r, start, payload+8)
+			if err != nil {
+				return nil, false, err
+			}
+			if le.Uint32(frame) != seekSkippableID || int64(le.Uint32(frame[4:])) != payload || descriptor&seekContinued != 0 {
+				return nil, false, ErrSeekTable
+			}
+			entries = append(parse(frame[8:], int(n), int(entryLen)), entries...)
+			end = start
+			break
+		}
+
+		start := end - seekGzipTailLen - payload - seekGzipHdrLen
+		member, err := readSeekBytes(r, start, seekGzipHdrLen+payload)
+		if err != nil {
+			return nil, false, err
+		}
+		if member[0] != gzipID1 || member[1] != gzipID2 || member[2] != gzipDeflate || member[3] != gzipFlagExtra ||
+			int64(le.Uint16(member[10:])) != 4+payload || member[12] != seekExtraID1 || member[13] != seekExtraID2 ||
+			int64(le.Uint16(member[14:])) != payload {
+			return nil, false, ErrSeekTable
+		}
+		entries = append(parse(member[seekGzipHdrLen:], int(n), int(entryLen)), entries...)
+		end = start
+		if descriptor&seekContinued == 0 {
+			break
+		}
+	}
+
+	var dataLen int64
+	for _, e := range entries {
+		if int64(e.usize) >= int64(max) {
+			return nil, false, ErrSeekTable
+		}
+		dataLen += int64(e.csize)
+	}
+	if len(entries) > 0 && dataLen != end {
+		return nil, false, ErrSeekTable
+	}
+	return entries, checksums, nil
+}
+
+// Rejects block sizes whose compressed blocks may not fit a seek table entry
+func checkSeekable(p params) error {
+	if int64(p.BlockSize) > math.MaxUint32 || int64(p.MaxBufferLength) > math.MaxUint32 {
+		return ErrParamSeekable
+	}
+	return nil
+}
+
+// SeekableReader reads a stream written by ParallelWriter with SeekableOption. It locates blocks
+// from the seek table at the end of the stream and decompresses only the blocks that overlap each read.
+// ReadAt is safe for concurrent use, Read and Seek share one offset.
+type SeekableReader struct {
+	r         io.ReaderAt
+	p         params
+	blocks    []seekBlock
+	checksums bool  // the seek table records CRC-32s
+	size      int64 // uncompressed size
+	off       int64 // offset of the next Read
+	mu        sync.Mutex
+	cached    int // block held in cache, -1 if none
+	cache     []byte
+}
+
+// Block located by the seek table
+type seekBlock struct {
+	seekEntry
+	coff int64 // offset in the compressed stream
+	uoff int64 // offset in the uncompressed data
+}
+
+// NewSeekableReader creates a SeekableReader over the size bytes of r.
+// Options are applied as for AcquireQzBinding and must select the algorithm and format written.
+// Blocks must decompress to less than MaxBufferLength bytes, otherwise ErrSeekTable is returned.
+func NewSeekableReader(r io.ReaderAt, size int64, options ...Option) (*SeekableReader, error) {
+	p, err := bindingParams(options...)
+	if err != nil {
+		return nil, err
+	}
+
+	entries, checksums, err := readSeekTable(r, size, p.MaxBufferLength)
+	if err != nil {
+		return nil, err
+	}
+
+	z := &SeekableReader{r: r, p: p, checksums: checksums, cached: -1}
+	z.blocks = make([]seekBlock, len(entries))
+	var coff, uoff int64
+	for i, e := range entries {
+		z.blocks[i] = seekBlock{seekEntry: e, coff: coff, uoff: uoff}
+		coff += int64(e.csize)
+		uoff += int64(e.usize)
+	}
+	z.size = uoff
+	return z, nil
+}
+
+// Size returns the uncompressed size of the stream
+func (z *SeekableReader) Size() int64 {
+	return z.size
+}
+
+// ReadAt reads len(p) uncompressed bytes starting at off
+func (z *SeekableReader) ReadAt(p []byte, off int64) (n int, err error) {
+	if off < 0 {
+		return 0, ErrSeekOffset
+	}
+
+	i := sort.Search(len(z.blocks), func(i int) bool {
+		return z.blocks[i].uoff+int64(z.blocks[i].usize) > off
+	})
+	for ; n < len(p) && i < len(z.blocks); i++ {
+		data, err := z.block(i)
+		if err != nil {
+			return n, err
+		}
+		n += copy(p[n:], data[off+int64(n)-z.blocks[i].uoff:])
+	}
+
+	if n < len(p) {
+		return n, io.EOF
+	}
+	return n, nil
+}
+
+// Read reads uncompressed data from the current offset
+func (z *SeekableReader) Read(p []byte) (n int, err error) {
+	n, err = z.ReadAt(p, z.off)
+	z.off += int64(n)
+	if err == io.EOF && n > 0 {
+		err = nil
+	}
+	return n, err
+}
+
+// Seek sets the offset of the next Read in the uncompressed data
+func (z *SeekableReader) Seek(offset int64, whence int) (int64, error) {
+	switch whence {
+	case io.SeekStart:
+	case io.SeekCurrent:
+		offset += z.off
+	case io.SeekEnd:
+		offset += z.size
+	default:
+		return z.off, ErrSeekOffset
+	}
+	if offset < 0 {
+		return z.off, ErrSeekOffset
+	}
+	z.off = offset
+	return offset, nil
+}
+
+// Returns the uncompressed data of block i, the most recent block is cached
+func (z *SeekableReader) block(i int) ([]byte, error) {
+	z.mu.Lock()
+	if z.cached == i {
+		data := z.cache
+		z.mu.Unlock()
+		return data, nil
+	}
+	z.mu.Unlock()
+
+	b := &z.blocks[i]
+	in, err := readSeekBytes(z.r, b.coff, int64(b.csize))
+	if err == ErrSeekTable {
+		err = ErrData
+	}
+	if err != nil {
+		return nil, err
+	}
+
+	q, err := acquireSession(z.p)
+	if err != nil {
+		return nil, err
+	}
+	out, n, err := decompressBlock(q, in, make([]byte, b.usize), int(b.usize), z.p.MaxBufferLength)
+	if err != nil {
+		q.Close()
+		return nil, err
+	}
+	if err = releaseSession(q); err != nil {
+		return nil, err
+	}
+	if n != int(b.usize) {
+		return nil, ErrData
+	}
+	data := out[:n]
+	if z.checksums && crc32.ChecksumIEEE(data) != b.crc {
+		return nil, ErrIntegrity
+	}
+
+	z.mu.Lock()
+	z.cached = i
+	z.cache = data
+	z.mu.Unlock()
+	return data, nil
+}
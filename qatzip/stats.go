@@ -0,0 +1,61 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+package qatzip
+
+/*
+#include "qatzip_internal.h"
+*/
+import "C"
+
+import "sync/atomic"
+
+// ExecStats counts QATzip requests by where they were executed.
+// QATzip falls back to software silently (SwBackupOption), a request is counted as software when the
+// session reports no hardware or no attached instance, or the input is below SwSwitchThreshold.
+// ZSTD compression counts as hardware when the QAT sequence producer is in use, libzstd may still
+// fall back internally (ZSTD_c_enableSeqProducerFallback). ZSTD decompression is always software.
+type ExecStats struct {
+	HwRequests        uint64 // requests executed on a QAT device
+	SwRequests        uint64 // requests executed in software
+	SwSmallRequests   uint64 // software requests below SwSwitchThreshold
+	SwBackoffRequests uint64 // software requests while no device is attached, retried after WaitCountThreshold calls
+	HwFallbacks       uint64 // sessions that lost their device and continued in software
+	HwRetries         uint64 // sessions that attached a device again after falling back
+}
+
+// GetExecStats returns the process-wide request counters
+func GetExecStats() ExecStats {
+	var s C.qatzip_stats_t
+	C.qatzip_get_stats(&s)
+	return execStats(&s)
+}
+
+func execStats(s *C.qatzip_stats_t) ExecStats {
+	return ExecStats{
+		HwRequests:        uint64(s.hw_requests),
+		SwRequests:        uint64(s.sw_requests),
+		SwSmallRequests:   uint64(s.sw_small_requests),
+		SwBackoffRequests: uint64(s.sw_backoff_requests),
+		HwFallbacks:       uint64(s.hw_fallbacks),
+		HwRetries:         uint64(s.hw_retries),
+	}
+}
+
+// Adds o to s, safe for concurrent use by the sessions of one stream
+func (s *ExecStats) add(o ExecStats) {
+	atomic.AddUint64(&s.HwRequests, o.HwRequests)
+	atomic.AddUint64(&s.SwRequests, o.SwRequests)
+	atomic.AddUint64(&s.SwSmallRequests, o.SwSmallRequests)
+	atomic.AddUint64(&s.SwBackoffRequests, o.SwBackoffRequests)
+	atomic.AddUint64(&s.HwFallbacks, o.HwFallbacks)
+	atomic.AddUint64(&s.HwRetries, o.HwRetries)
+}
+
+// Moves the counters of session q into the Perf of the stream using it
+func (q *QzBinding) collectStats() {
+	var s C.qatzip_stats_t
+	C.qatzip_take_stats(q.state, &s)
+	if q.perf != nil {
+		q.perf.ExecStats.add(execStats(&s))
+	}
+}
@@ -0,0 +1,193 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+package qatzip
+
+import (
+	"hash/crc32"
+	"math"
+)
+
+const (
+	storeSampleLen   = 256  // bytes per sample window of the entropy probe
+	storeSamples     = 16   // sample windows per probed segment
+	storeMinLength   = 4096 // shorter inputs are always sent to QATzip
+	storeMaxEntropy  = 7.8  // order-0 entropy (bits per byte) above which a segment is stored
+	storeSegment     = 64 * 1024
+	storeDeflateLen  = 65535 // largest DEFLATE stored block
+	storeLZ4Len      = 64 * 1024
+	storeZstdLen     = 128 * 1024 // largest ZSTD block
+	storeGzipExtLen  = 32         // header with QZ extra field, CRC-32 and ISIZE
+	storeGzipLen     = 18         // header, CRC-32 and ISIZE
+	storeLZ4FrameLen = 11         // header and end mark
+	storeZstdHdrLen  = 9          // magic, descriptor and 4 byte content size
+
+	/* LZ4 frame of independent 64KB blocks without checksums */
+	lz4StoredFLG uint8 = 0x60
+	lz4StoredHC  uint8 = 0x82
+)
+
+// Reports whether stored output can be produced for the format configured by p
+func storeSupported(p params) bool {
+	switch p.Algorithm {
+	case DEFLATE:
+		return p.DataFmtDeflate == DeflateGzip || p.DataFmtDeflate == DeflateGzipExt
+	case LZ4:
+		return true
+	case ZSTD:
+		return p.ZstdChecksum == 0 && p.ZstdWindowLog == 0
+	}
+	return false
+}
+
+// Reports whether b looks incompressible: the order-0 entropy of evenly spaced samples is close to 8 bits per byte
+func incompressible(b []byte) bool {
+	var hist [256]int
+
+	if len(b) < storeMinLength {
+		return false
+	}
+
+	n := 0
+	stride := (len(b) - storeSampleLen) / (storeSamples - 1)
+	for i := 0; i < storeSamples; i++ {
+		for _, c := range b[i*stride : i*stride+storeSampleLen] {
+			hist[c]++
+		}
+		n += storeSampleLen
+	}
+
+	entropy := 0.0
+	for _, c := range hist {
+		if c > 0 {
+			p := float64(c) / float64(n)
+			entropy -= p * math.Log2(p)
+		}
+	}
+	return entropy > storeMaxEntropy
+}
+
+// Length of the stored members/frame of n bytes
+func storedLength(p params, n int) int {
+	blocks := func(n int, max int) int { return (n + max - 1) / max }
+	switch {
+	case p.Algorithm == LZ4:
+		return storeLZ4FrameLen + n + 4*blocks(n, storeLZ4Len)
+	case p.Algorithm == ZSTD:
+		return storeZstdHdrLen + n + 3*blocks(n, storeZstdLen)
+	case p.DataFmtDeflate == DeflateGzipExt:
+		hw := p.hwBufSize()
+		members, last := n/hw, n%hw
+		length := members * (storeGzipExtLen + hw + 5*blocks(hw, storeDeflateLen))
+		if last > 0 {
+			length += storeGzipExtLen + last + 5*blocks(last, storeDeflateLen)
+		}
+		return length
+	}
+	return storeGzipLen + n + 5*blocks(n, storeDeflateLen)
+}
+
+// Appends src as a complete gzip member of DEFLATE stored blocks (one member per hardware buffer with the
+// QZ extra field, as QATzip writes them), LZ4 frame of uncompressed blocks or ZSTD frame of raw blocks.
+// src must not be empty and shorter than 4GB.
+func appendStored(p params, buf []byte, src []byte) []byte {
+	append16 := func(buf []byte, v uint16) []byte { return append(buf, uint8(v), uint8(v>>8)) }
+	append32 := func(buf []byte, v uint32) []byte {
+		return append(buf, uint8(v), uint8(v>>8), uint8(v>>16), uint8(v>>24))
+	}
+
+	switch p.Algorithm {
+	case LZ4:
+		buf = append32(buf, lz4ID)
+		buf = append(buf, lz4StoredFLG, lz4BD, lz4StoredHC)
+		for off := 0; off < len(src); off += storeLZ4Len {
+			b := src[off:minInt(off+storeLZ4Len, len(src))]
+			buf = append32(buf, uint32(len(b))|0x80000000)
+			buf = append(buf, b...)
+		}
+		return append32(buf, 0)
+
+	case ZSTD:
+		buf = append32(buf, zstdMagic)
+		buf = append(buf, 0xa0) // single segment, 4 byte content size
+		buf = append32(buf, uint32(len(src)))
+		for off := 0; off < len(src); off += storeZstdLen {
+			b := src[off:minInt(off+storeZstdLen, len(src))]
+			h := uint32(len(b)) << 3 // raw block
+			if off+len(b) == len(src) {
+				h |= 1
+			}
+			buf = append(buf, uint8(h), uint8(h>>8), uint8(h>>16))
+			buf = append(buf, b...)
+		}
+		return buf
+	}
+
+	if p.DataFmtDeflate == DeflateGzipExt && len(src) > p.hwBufSize() {
+		for off := 0; off < len(src); off += p.hwBufSize() {
+			buf = appendStored(p, buf, src[off:minInt(off+p.hwBufSize(), len(src))])
+		}
+		return buf
+	}
+
+	blocks := (len(src) + storeDeflateLen - 1) / storeDeflateLen
+	buf = appendGzipHeader(buf, p.DataFmtDeflate == DeflateGzipExt, len(src), len(src)+5*blocks)
+	for off := 0; off < len(src); off += storeDeflateLen {
+		b := src[off:minInt(off+storeDeflateLen, len(src))]
+		final := uint8(0)
+		if off+len(b) == len(src) {
+			final = 1
+		}
+		buf = append(buf, final)
+		buf = append16(buf, uint16(len(b)))
+		buf = append16(buf, ^uint16(len(b)))
+		buf = append(buf, b...)
+	}
+	return appendGzipTrailer(buf, src)
+}
+
+// Appends a gzip member header, with the QZ extra field recording usize and the DEFLATE data length csize if ext is set
+func appendGzipHeader(buf []byte, ext bool, usize int, csize int) []byte {
+	if !ext {
+		return append(buf, gzipID1, gzipID2, gzipDeflate, 0, 0, 0, 0, 0, 0, osType)
+	}
+	buf = append(buf, gzipID1, gzipID2, gzipDeflate, gzipFlagExtra, 0, 0, 0, 0, 0, osType)
+	buf = append(buf, 4+qzExtraLen, 0, qzExtraID1, qzExtraID2, qzExtraLen, 0)
+	buf = append(buf, uint8(usize), uint8(usize>>8), uint8(usize>>16), uint8(usize>>24))
+	return append(buf, uint8(csize), uint8(csize>>8), uint8(csize>>16), uint8(csize>>24))
+}
+
+// Appends the CRC-32 and ISIZE trailer of the gzip member of src
+func appendGzipTrailer(buf []byte, src []byte) []byte {
+	crc, n := crc32.ChecksumIEEE(src), uint32(len(src))
+	return append(buf, uint8(crc), uint8(crc>>8), uint8(crc>>16), uint8(crc>>24), uint8(n), uint8(n>>8), uint8(n>>16), uint8(n>>24))
+}
+
+// Stores in as one member/frame into out, which grows if needed, and returns out, the stored length and CRC-32 of in
+func storeBlock(p params, in []byte, out []byte) ([]byte, int, uint32) {
+	if n := storedLength(p, len(in)); n > len(out) {
+		out = make([]byte, n)
+	}
+	return out, len(appendStored(p, out[:0], in)), crc32.ChecksumIEEE(in)
+}
+
+// Splits p into runs of segments with the same incompressible() result and calls fn for each run
+func storeRuns(p []byte, fn func(run []byte, stored bool) error) error {
+	segment := func(off int) []byte { return p[off:minInt(off+storeSegment, len(p))] }
+
+	next := incompressible(segment(0))
+	for start := 0; start < len(p); {
+		stored := next
+		end := start + len(segment(start))
+		for end < len(p) {
+			if next = incompressible(segment(end)); next != stored {
+				break
+			}
+			end += len(segment(end))
+		}
+		if err := fn(p[start:end], stored); err != nil {
+			return err
+		}
+		start = end
+	}
+	return nil
+}
@@ -20,20 +20,54 @@ func getTraceLevel() (level DebugLevel) {
 	return DebugLevel(l)
 }
 
+// Reports whether messages at level are printed for q (DebugLevel High) or recorded in a running execution trace.
+// Callers check it before traceLogf so that disabled messages do not format or box their arguments.
+func traceOn(level DebugLevel, q *QzBinding) bool {
+	if !traceCompiled || q == nil {
+		return false
+	}
+	debug := q.getDebug()
+	return debug >= High || (debug >= level && trace.IsEnabled())
+}
+
 func traceLogf(level DebugLevel, q *QzBinding, ctx context.Context, format string, args ...any) {
-	if q == nil {
+	if !traceOn(level, q) {
 		return
 	}
 
+	msg := fmt.Sprintf(format, args...)
 	if q.getDebug() >= High {
-		fmt.Fprintln(os.Stderr, fmt.Sprintf(format, args...))
+		fmt.Fprintln(os.Stderr, msg)
 	}
 
 	if q.getDebug() >= level {
-		trace.Log(ctx, "", fmt.Sprintf(format, args...))
+		trace.Log(ctx, "", msg)
 	}
 }
 
+// Starts a trace region, nil unless an execution trace is running
+func startRegion(ctx context.Context, regionType string) *trace.Region {
+	if !traceCompiled || !trace.IsEnabled() {
+		return nil
+	}
+	return trace.StartRegion(ctx, regionType)
+}
+
+// Ends a region returned by startRegion
+func endRegion(r *trace.Region) {
+	if r != nil {
+		r.End()
+	}
+}
+
+func (z *Writer) traceOn(level DebugLevel) bool {
+	return traceOn(level, z.q)
+}
+
+func (z *Reader) traceOn(level DebugLevel) bool {
+	return traceOn(level, z.q)
+}
+
 func (z *Writer) traceLogf(level DebugLevel, format string, args ...any) {
 	traceLogf(level, z.q, z.ctx, format, args...)
 }
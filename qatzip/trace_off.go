@@ -0,0 +1,13 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+//go:build qatgo_notrace
+
+package qatzip
+
+/*
+#cgo CFLAGS: -DQATGO_NO_DEBUG
+*/
+import "C"
+
+// Tracing and debug output are compiled out (-tags qatgo_notrace)
+const traceCompiled = false
@@ -0,0 +1,8 @@
+// Copyright(c) 2022-2023 Intel Corporation. All rights reserved.
+
+//go:build !qatgo_notrace
+
+package qatzip
+
+// Tracing and debug output are compiled in, build with -tags qatgo_notrace to remove them
+const traceCompiled = true